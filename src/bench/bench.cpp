@@ -0,0 +1,444 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "workload_generator.h"
+
+using namespace std;
+
+//
+// Benchmark definitions
+//
+#define PHASE_COUNT         6
+#define DEFAULT_SEED        2019
+#define DEFAULT_RUNS        3
+#define DEFAULT_TOLERANCE   25
+
+/**
+ * Struct holding the measured costs of a single profile.
+ */
+struct ProfileResult {
+    string profile;
+    int lines = 0;
+    double wall = 0;                    // The median wall time of the whole compiler process in milliseconds
+    double linesPerSec = 0;             // The throughput of the whole pipeline
+    double phases[PHASE_COUNT] = {};    // The wall time of each phase in milliseconds, of the median run
+    long peakRss = 0;                   // The peak resident set size in KB, of the median run
+    size_t allocs = 0;                  // The number of heap allocations, of the median run
+    bool valid = false;                 // Whether the compiler accepted the program and reported its costs
+};
+
+//
+// Global Variables
+//
+const char* phaseNames[PHASE_COUNT] = {"lexing", "parsing", "analysis", "generation", "symbol_table", "output"};
+
+string compilerPath;
+string workDir = ".";
+string baselineFilename;
+string resultsFilename;
+string generateFilename;
+string extraFlags;
+vector<string> profiles;
+double scaleFactor = 1;
+uint64_t seed = DEFAULT_SEED;
+int runs = DEFAULT_RUNS;
+int threads = 1;
+double tolerance = DEFAULT_TOLERANCE;
+bool updateBaseline = false;
+
+//
+// Functions prototypes
+//
+ProfileResult runProfile(const string& profile);
+bool readTimeReport(const string& filename, ProfileResult& result);
+map<string, double> readBaseline(const string& filename);
+void writeBaseline(const vector<ProfileResult>& results, const string& filename);
+int generateProgram(const string& profile, const string& filename);
+string quote(const string& path);
+void printHelp();
+void parseArguments(int argc, char* argv[]);
+
+
+/**
+ * Benchmark driver program.
+ *
+ * Generates a program of each profile, compiles it through the whole pipeline of the compiler,
+ * and reports its throughput and the costs of each phase as measured by the compiler's time report.
+ * The throughput is compared against a baseline file, and the program fails if any profile regresses.
+ *
+ * @param argc the number of arguments sent to the program.
+ * @param argv the arguments them self as sent to the program.
+ */
+int main(int argc, char* argv[]) {
+    parseArguments(argc, argv);
+
+    if (profiles.empty()) {
+        profiles = WorkloadGenerator::profiles();
+    }
+
+    if (!generateFilename.empty()) {
+        return generateProgram(profiles[0], generateFilename);
+    }
+
+    if (compilerPath.empty()) {
+        fprintf(stderr, "error: missing compiler path!\n\n");
+        printHelp();
+    }
+
+    map<string, double> baseline;
+
+    if (!baselineFilename.empty() && !updateBaseline) {
+        baseline = readBaseline(baselineFilename);
+    }
+
+    vector<ProfileResult> results;
+    bool failed = false;
+
+    printf("%-14s %8s %11s %12s", "profile", "lines", "wall (ms)", "lines/sec");
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        printf(" %12s", phaseNames[i]);
+    }
+    printf(" %10s %10s %9s\n", "RSS (KB)", "allocs", "baseline");
+
+    for (int i = 0; i < profiles.size(); ++i) {
+        ProfileResult result = runProfile(profiles[i]);
+        results.push_back(result);
+
+        if (!result.valid) {
+            printf("%-14s failed to compile, see %s/%s.log\n", result.profile.c_str(), workDir.c_str(), result.profile.c_str());
+            failed = true;
+            continue;
+        }
+
+        printf("%-14s %8d %11.1f %12.0f", result.profile.c_str(), result.lines, result.wall, result.linesPerSec);
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            printf(" %12.1f", result.phases[p]);
+        }
+        printf(" %10ld %10zu", result.peakRss, result.allocs);
+
+        // Compare the throughput against the baseline, allowing for the noise of the machine
+        auto it = baseline.find(result.profile);
+
+        if (it == baseline.end()) {
+            printf(" %9s\n", "-");
+        } else {
+            double change = (result.linesPerSec / it->second - 1) * 100;
+            bool regressed = (change < -tolerance);
+
+            printf(" %+8.1f%%%s\n", change, regressed ? "  REGRESSION" : "");
+            failed |= regressed;
+        }
+
+        fflush(stdout);
+    }
+
+    if (!resultsFilename.empty()) {
+        writeBaseline(results, resultsFilename);
+    }
+
+    if (updateBaseline && !baselineFilename.empty()) {
+        writeBaseline(results, baselineFilename);
+        printf("baseline written to '%s'\n", baselineFilename.c_str());
+    }
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * Generates the program of the given profile, and compiles it the configured number of times.
+ *
+ * @param profile the name of the profile.
+ *
+ * @return the costs of the median run.
+ */
+ProfileResult runProfile(const string& profile) {
+    ProfileResult ret;
+    ret.profile = profile;
+
+    string base = workDir + "/" + profile;
+    WorkloadGenerator generator(seed);
+    string source = generator.generate(profile, (int) (WorkloadGenerator::defaultScale(profile) * scaleFactor));
+
+    ofstream fout(base + ".mpp");
+
+    if (source.empty() || !fout.is_open()) {
+        return ret;
+    }
+
+    fout << source;
+    fout.close();
+    ret.lines = generator.lines();
+
+    string command = quote(compilerPath) + " " + quote(base + ".mpp") +
+                     " -o " + quote(base + ".quad") + " -s " + quote(base + ".sym") +
+                     " -j" + to_string(threads) + " --time-report=json " + extraFlags +
+                     " > " + quote(base + ".log") + " 2> " + quote(base + ".json");
+
+    vector<ProfileResult> samples;
+
+    for (int i = 0; i < runs; ++i) {
+        ProfileResult sample = ret;
+
+        auto start = chrono::steady_clock::now();
+        int status = system(command.c_str());
+        sample.wall = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        // The compiler writes an empty output file if the program is invalid
+        ifstream quads(base + ".quad");
+        sample.valid = (status == 0 && quads.is_open() && quads.peek() != EOF && readTimeReport(base + ".json", sample));
+
+        if (!sample.valid) {
+            return sample;
+        }
+
+        sample.linesPerSec = ret.lines / max(sample.wall / 1000, 1e-9);
+        samples.push_back(sample);
+    }
+
+    sort(samples.begin(), samples.end(), [](const ProfileResult& a, const ProfileResult& b) {
+        return a.wall < b.wall;
+    });
+
+    return samples[samples.size() / 2];
+}
+
+/**
+ * Reads the costs of each phase from the JSON time report of the compiler.
+ *
+ * @param filename the filename of the time report.
+ * @param result   the result to store the costs into.
+ *
+ * @return {@code true} if the report holds all the phases; {@code false} otherwise.
+ */
+bool readTimeReport(const string& filename, ProfileResult& result) {
+    ifstream fin(filename);
+    stringstream ss;
+    ss << fin.rdbuf();
+    string report = ss.str();
+
+    for (int i = 0; i <= PHASE_COUNT; ++i) {
+        string key = "\"" + string(i < PHASE_COUNT ? phaseNames[i] : "total") + "\": {";
+        size_t pos = report.find(key);
+        double wall, cpu;
+        long rss;
+        size_t allocs;
+
+        if (pos == string::npos ||
+            sscanf(report.c_str() + pos + key.size(),
+                   " \"wall_ms\": %lf, \"cpu_ms\": %lf, \"peak_rss_kb\": %ld, \"heap_allocations\": %zu",
+                   &wall, &cpu, &rss, &allocs) != 4) {
+            return false;
+        }
+
+        if (i < PHASE_COUNT) {
+            result.phases[i] = wall;
+        } else {
+            result.peakRss = rss;
+            result.allocs = allocs;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Reads the baseline throughput of each profile from the given file.
+ *
+ * Each line holds a profile name and its throughput in lines per second, separated by spaces.
+ * Empty lines and lines beginning with '#' are ignored.
+ *
+ * @param filename the filename of the baseline.
+ *
+ * @return the throughput of each profile.
+ */
+map<string, double> readBaseline(const string& filename) {
+    map<string, double> ret;
+    ifstream fin(filename);
+
+    if (!fin.is_open()) {
+        fprintf(stderr, "warning: could not open the baseline file '%s'\n", filename.c_str());
+        return ret;
+    }
+
+    string line;
+
+    while (getline(fin, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        stringstream ss(line);
+        string profile;
+        double linesPerSec;
+
+        if (ss >> profile >> linesPerSec) {
+            ret[profile] = linesPerSec;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Writes the throughput of the given results in the format of a baseline file.
+ *
+ * @param results  the results of the profiles.
+ * @param filename the filename to write into.
+ */
+void writeBaseline(const vector<ProfileResult>& results, const string& filename) {
+    ofstream fout(filename);
+
+    if (!fout.is_open()) {
+        fprintf(stderr, "error: could not write in file '%s'!\n", filename.c_str());
+        return;
+    }
+
+    fout << "# M++ benchmark baseline: <profile> <lines/sec> <lines>\n";
+    fout << "# seed " << seed << ", scale " << scaleFactor << ", " << runs << " runs, -j" << threads << "\n";
+
+    for (int i = 0; i < results.size(); ++i) {
+        if (results[i].valid) {
+            fout << results[i].profile << " " << (long long) results[i].linesPerSec << " " << results[i].lines << "\n";
+        }
+    }
+
+    fout.close();
+}
+
+/**
+ * Generates the program of the given profile into the given file, without compiling it.
+ *
+ * @param profile  the name of the profile.
+ * @param filename the filename to write into.
+ *
+ * @return the exit code of the program.
+ */
+int generateProgram(const string& profile, const string& filename) {
+    WorkloadGenerator generator(seed);
+    string source = generator.generate(profile, (int) (WorkloadGenerator::defaultScale(profile) * scaleFactor));
+
+    if (source.empty()) {
+        fprintf(stderr, "error: unknown profile '%s'!\n", profile.c_str());
+        return 1;
+    }
+
+    ofstream fout(filename);
+
+    if (!fout.is_open()) {
+        fprintf(stderr, "error: could not write in file '%s'!\n", filename.c_str());
+        return 1;
+    }
+
+    fout << source;
+    printf("%s: %d lines\n", filename.c_str(), generator.lines());
+    return 0;
+}
+
+/**
+ * Quotes the given path to be passed to the shell.
+ */
+string quote(const string& path) {
+    return "\"" + path + "\"";
+}
+
+/**
+ * Prints the help menu of the benchmark into the
+ * standard output stream, then terminates the program.
+ */
+void printHelp() {
+    printf("Usage: mpp-bench --compiler <path> [switches]\n");
+    printf("       mpp-bench --generate <filename> --profile <name> [--scale <factor>] [--seed <n>]\n");
+    printf("    -h, --help                   Print the help menu and exit.\n");
+    printf("    --compiler <path>            Specify the compiler executable to benchmark.\n");
+    printf("    --profile <name>             Benchmark the given profile only, can be repeated (default: all).\n");
+    printf("    --scale <factor>             Multiply the size of the generated programs (default: 1).\n");
+    printf("    --seed <n>                   Specify the seed of the generated programs (default: %d).\n", DEFAULT_SEED);
+    printf("    --runs <n>                   Specify the number of runs per profile, the median is kept (default: %d).\n", DEFAULT_RUNS);
+    printf("    -j<count>                    Specify the number of compilation threads (default: 1).\n");
+    printf("    --flags <flags>              Pass the given extra flags to the compiler.\n");
+    printf("    --work-dir <dir>             Specify the existing directory of the generated files (default: .).\n");
+    printf("    --baseline <filename>        Compare the throughput against the given baseline file.\n");
+    printf("    --tolerance <percent>        Specify the allowed throughput regression (default: %d).\n", DEFAULT_TOLERANCE);
+    printf("    --update-baseline            Write the measured throughput into the baseline file instead.\n");
+    printf("    --results <filename>         Write the measured throughput into the given file.\n");
+    printf("\nProfiles:");
+    for (const string& profile : WorkloadGenerator::profiles()) {
+        printf(" %s", profile.c_str());
+    }
+    printf("\n");
+    exit(0);
+}
+
+/**
+ * Parses the passed arguments to the benchmark, and updates global variables in correspondence.
+ *
+ * @param argc the number of arguments sent to the program.
+ * @param argv the arguments them self as sent to the program.
+ */
+void parseArguments(int argc, char* argv[]) {
+    // Returns the value of the current switch
+    auto value = [&]() {
+        if (--argc < 1) {
+            fprintf(stderr, "error: missing value of '%s'!\n\n", *argv);
+            printHelp();
+        }
+
+        return string(*(++argv));
+    };
+
+    while (++argv, --argc) {
+        if (strcmp(*argv, "-h") == 0 || strcmp(*argv, "--help") == 0) {
+            printHelp();
+        }
+        else if (strcmp(*argv, "--compiler") == 0) {
+            compilerPath = value();
+        }
+        else if (strcmp(*argv, "--generate") == 0) {
+            generateFilename = value();
+        }
+        else if (strcmp(*argv, "--profile") == 0) {
+            profiles.push_back(value());
+        }
+        else if (strcmp(*argv, "--scale") == 0) {
+            scaleFactor = atof(value().c_str());
+        }
+        else if (strcmp(*argv, "--seed") == 0) {
+            seed = strtoull(value().c_str(), NULL, 10);
+        }
+        else if (strcmp(*argv, "--runs") == 0) {
+            runs = max(atoi(value().c_str()), 1);
+        }
+        else if (strncmp(*argv, "-j", 2) == 0) {
+            threads = max(atoi(*argv + 2), 1);
+        }
+        else if (strcmp(*argv, "--flags") == 0) {
+            extraFlags = value();
+        }
+        else if (strcmp(*argv, "--work-dir") == 0) {
+            workDir = value();
+        }
+        else if (strcmp(*argv, "--baseline") == 0) {
+            baselineFilename = value();
+        }
+        else if (strcmp(*argv, "--tolerance") == 0) {
+            tolerance = atof(value().c_str());
+        }
+        else if (strcmp(*argv, "--update-baseline") == 0) {
+            updateBaseline = true;
+        }
+        else if (strcmp(*argv, "--results") == 0) {
+            resultsFilename = value();
+        }
+        else {
+            fprintf(stderr, "unknown argument '%s'\n", *argv);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,446 @@
+#ifndef __WORKLOAD_GENERATOR_H_
+#define __WORKLOAD_GENERATOR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Class generating synthetic, semantically valid M++ programs to benchmark the compiler with.
+ *
+ * Each profile stresses a different shape of source code, and its size grows linearly with the given scale.
+ * The programs only depend on the seed: the random numbers are drawn from a self-contained generator
+ * rather than from the standard distributions, whose results differ between standard libraries.
+ */
+class WorkloadGenerator {
+    uint64_t state;         // The state of the random number generator
+    string out;             // The generated source code
+    int indent = 0;         // The indentation level of the next line
+    int lineCount = 0;      // The number of generated lines
+
+public:
+
+    /**
+     * Constructs a new workload generator.
+     *
+     * @param seed the seed of the random number generator.
+     */
+    WorkloadGenerator(uint64_t seed) : state(seed) {
+
+    }
+
+    /**
+     * Returns the names of the available profiles.
+     */
+    static vector<string> profiles() {
+        return {"functions", "nesting", "switch", "expressions", "shadowing", "declarations"};
+    }
+
+    /**
+     * Returns the scale of the given profile generating a program of about 20k to 40k lines.
+     */
+    static int defaultScale(const string& profile) {
+        if (profile == "functions")     return 2000;
+        if (profile == "nesting")       return 4000;
+        if (profile == "switch")        return 10000;
+        if (profile == "expressions")   return 200000;
+        if (profile == "shadowing")     return 15000;
+        if (profile == "declarations")  return 100000;
+        return 0;
+    }
+
+    /**
+     * Generates a program of the given profile.
+     *
+     * @param profile the name of the profile (see {@code profiles}).
+     * @param scale   the size of the program:
+     *                the number of functions for "functions", the number of nested blocks for "nesting",
+     *                the number of case labels for "switch", the number of operands for "expressions",
+     *                and the number of declared variables for "shadowing" and "declarations".
+     *
+     * @return the source code of the program, or an empty string if the profile is unknown.
+     */
+    string generate(const string& profile, int scale) {
+        out.clear();
+        indent = 0;
+        lineCount = 0;
+
+        if (profile == "functions") {
+            genFunctions(scale);
+        } else if (profile == "nesting") {
+            genNesting(scale);
+        } else if (profile == "switch") {
+            genSwitch(scale);
+        } else if (profile == "expressions") {
+            genExpressions(scale);
+        } else if (profile == "shadowing") {
+            genShadowing(scale);
+        } else if (profile == "declarations") {
+            genDeclarations(scale);
+        } else {
+            return "";
+        }
+
+        return out;
+    }
+
+    /**
+     * Returns the number of lines of the last generated program.
+     */
+    int lines() const {
+        return lineCount;
+    }
+
+private:
+
+    /**
+     * Returns the next random number, using the SplitMix64 generator.
+     */
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * Returns a random integer in the range {@code [lo, hi]}.
+     */
+    int range(int lo, int hi) {
+        return lo + (int) (next() % (uint64_t) (hi - lo + 1));
+    }
+
+    /**
+     * Returns a random element of the given list.
+     */
+    const string& pick(const vector<string>& list) {
+        return list[next() % list.size()];
+    }
+
+    /**
+     * Appends a line of source code at the current indentation, opening or closing a block on braces.
+     */
+    void line(const string& text) {
+        if (!text.empty() && text[0] == '}') {
+            indent--;
+        }
+
+        out.append(4 * indent, ' ');
+        out += text;
+        out += '\n';
+        lineCount++;
+
+        if (!text.empty() && text.back() == '{') {
+            indent++;
+        }
+    }
+
+    /**
+     * Returns a random arithmetic expression of the given number of operands,
+     * over the given initialized integer variables and small constants.
+     */
+    string expr(int operands, const vector<string>& vars) {
+        static const vector<string> oprs = {" + ", " - ", " * ", " & ", " | ", " ^ "};
+
+        string ret;
+        int open = 0;
+
+        for (int i = 0; i < operands; ++i) {
+            if (i > 0) {
+                ret += pick(oprs);
+            }
+
+            if (i + 1 < operands && range(0, 7) == 0) {
+                ret += '(';
+                open++;
+            }
+
+            ret += range(0, 3) == 0 ? to_string(range(1, 99)) : pick(vars);
+
+            if (open > 0 && range(0, 3) == 0) {
+                ret += ')';
+                open--;
+            }
+        }
+
+        return ret + string(open, ')');
+    }
+
+    /**
+     * Returns a random comparison over the given initialized integer variables.
+     */
+    string cond(const vector<string>& vars) {
+        static const vector<string> oprs = {" < ", " <= ", " > ", " >= ", " == ", " != "};
+        return pick(vars) + pick(oprs) + expr(range(1, 3), vars);
+    }
+
+    /**
+     * Generates functions with parameters, local variables, loops, branches,
+     * and calls to the previous functions.
+     */
+    void genFunctions(int count) {
+        for (int i = 0; i < count; ++i) {
+            vector<string> vars = {"a", "b", "c", "x", "y"};
+
+            line("int f" + to_string(i) + "(int a, int b, int c) {");
+            line("int x = " + expr(3, {"a", "b", "c"}) + ", y = " + expr(3, {"a", "b", "c"}) + ";");
+            line("int s = 0;");
+            line("for (int j = 0; j < c; ++j) {");
+            line("s = s + " + expr(range(2, 4), vars) + ";");
+            line("}");
+            line("if (" + cond(vars) + ") {");
+            line(i > 0 ? "s = s - f" + to_string(range(0, i - 1)) + "(a, b, s);" : "s = s - a;");
+            line("} else {");
+            line("s = s + " + expr(range(2, 4), vars) + ";");
+            line("}");
+            line("while (x > 0) {");
+            line("x = x - 1;");
+            line("y = y + " + expr(2, vars) + ";");
+            line("}");
+            line("return s + y;");
+            line("}");
+            line("");
+        }
+
+        line("int main() {");
+        line("int r = 0;");
+
+        for (int i = max(count - 16, 0); i < count; ++i) {
+            line("r = r + f" + to_string(i) + "(r, " + to_string(range(1, 9)) + ", " + to_string(range(1, 9)) + ");");
+        }
+
+        line("return r;");
+        line("}");
+    }
+
+    /**
+     * Generates functions made of deeply nested if, while, do-while and for statements.
+     */
+    void genNesting(int blocks) {
+        const int depth = 48;
+
+        for (int f = 0; f * depth < blocks; ++f) {
+            vector<bool> doWhile(depth + 1);
+
+            line("int n" + to_string(f) + "(int v0) {");
+
+            for (int d = 1; d <= depth; ++d) {
+                string outer = "v" + to_string(d - 1);
+                string var = "v" + to_string(d);
+
+                line("int " + var + " = " + outer + " + " + to_string(range(1, 9)) + ";");
+
+                switch (range(0, 3)) {
+                    case 0:
+                        line("if (" + var + " > " + outer + ") {");
+                        break;
+                    case 1:
+                        line("while (" + var + " > " + to_string(range(0, 99)) + ") {");
+                        line(var + " = " + var + " - " + to_string(range(1, 9)) + ";");
+                        break;
+                    case 2:
+                        line("for (int i" + to_string(d) + " = 0; i" + to_string(d) + " < " + var + "; ++i" + to_string(d) + ") {");
+                        break;
+                    default:
+                        doWhile[d] = true;
+                        line("do {");
+                        line(var + " = " + var + " - 1;");
+                        break;
+                }
+            }
+
+            line("v0 = v0 + v" + to_string(depth) + ";");
+
+            for (int d = depth; d >= 1; --d) {
+                string outer = "v" + to_string(d - 1);
+
+                // Close a do-while loop with its condition, or any other block with a plain brace
+                line(doWhile[d] ? "} while (" + outer + " > 0);" : "}");
+                line(outer + " = " + outer + " * 2 + 1;");
+            }
+
+            line("return v0;");
+            line("}");
+            line("");
+        }
+
+        line("int main() {");
+        line("return n0(1);");
+        line("}");
+    }
+
+    /**
+     * Generates functions holding huge switch statements, with fall-through cases and default labels.
+     */
+    void genSwitch(int labels) {
+        const int cases = 2000;
+
+        for (int f = 0; f * cases < labels; ++f) {
+            vector<string> vars = {"x", "r"};
+
+            line("int s" + to_string(f) + "(int x) {");
+            line("int r = 0;");
+            line("switch (x) {");
+
+            for (int i = 0, value = 0; i < cases; ++i) {
+                value += range(1, 3);
+                line("case " + to_string(value) + ":");
+                indent++;
+                line("r = r + " + expr(range(1, 4), vars) + ";");
+
+                if (range(0, 4) != 0) {
+                    line("break;");
+                }
+                indent--;
+            }
+
+            line("default:");
+            indent++;
+            line("r = -1;");
+            indent--;
+            line("}");
+            line("return r;");
+            line("}");
+            line("");
+        }
+
+        line("int main() {");
+        line("return s0(7);");
+        line("}");
+    }
+
+    /**
+     * Generates functions evaluating long chains of arithmetic, relational and logical operators.
+     */
+    void genExpressions(int operands) {
+        vector<string> vars = {"a", "b", "c", "d"};
+        int f = 0;
+
+        while (operands > 0) {
+            line("int e" + to_string(f++) + "(int a, int b, int c, int d) {");
+
+            for (int i = 0; i < 8 && operands > 0; ++i) {
+                int n = range(50, 500);
+                operands -= n;
+
+                // Wrap the chain every few operands, as an expression can span multiple lines
+                string text = pick(vars) + " = ";
+
+                for (int j = 0; j < n; j += 16) {
+                    text += (j > 0 ? "    " : "") + expr(min(n - j, 16), vars);
+
+                    if (j + 16 < n) {
+                        line(text + (range(0, 1) ? " +" : " -"));
+                        text = "";
+                    }
+                }
+
+                line(text + ";");
+                line("if (" + cond(vars) + " && " + cond(vars) + " || !(" + cond(vars) + ")) {");
+                line("a = a + 1;");
+                line("}");
+            }
+
+            line("return a + b + c + d;");
+            line("}");
+            line("");
+        }
+
+        line("int main() {");
+        line("return e0(1, 2, 3, 4);");
+        line("}");
+    }
+
+    /**
+     * Generates functions redeclaring the same variable names in every nested block.
+     */
+    void genShadowing(int declarations) {
+        const int names = 16;
+        const int depth = 8;
+
+        for (int f = 0; f * names * depth < declarations; ++f) {
+            line("int h" + to_string(f) + "(int t) {");
+
+            for (int d = 0; d < depth; ++d) {
+                for (int k = 0; k < names; ++k) {
+                    string init = (d == 0 ? "t" : "v" + to_string(range(0, names - 1)));
+                    line("int u" + to_string(k) + " = " + init + " + " + to_string(range(1, 9)) + ";");
+                }
+
+                // The temporaries hold the outer values, since a declaration hides the outer variable in its own initializer
+                for (int k = 0; k < names; ++k) {
+                    line("int v" + to_string(k) + " = u" + to_string(k) + " * 2;");
+                }
+
+                line("t = t + v" + to_string(range(0, names - 1)) + " + u" + to_string(range(0, names - 1)) + ";");
+                line("{");
+            }
+
+            for (int d = 0; d < depth; ++d) {
+                line("t = t - 1;");
+                line("}");
+            }
+
+            line("return t;");
+            line("}");
+            line("");
+        }
+
+        line("int main() {");
+        line("return h0(1);");
+        line("}");
+    }
+
+    /**
+     * Generates wide lists of variables declared together, in the global scope and in functions.
+     */
+    void genDeclarations(int variables) {
+        const int width = 256;
+        int lists = max((variables + width - 1) / width, 2);
+
+        for (int l = 0; l < lists; ++l) {
+            bool global = (l % 4 == 0);
+            string prefix = "g" + to_string(l) + "_";
+
+            if (!global) {
+                line("int d" + to_string(l) + "(int p) {");
+            }
+
+            string decl = (global ? "const int " : "int ");
+
+            for (int i = 0; i < width; ++i) {
+                string init = (i == 0 ? (global ? to_string(range(1, 9)) : "p") :
+                               prefix + to_string(range(max(i - 8, 0), i - 1)) + " + " + to_string(range(1, 9)));
+
+                decl += prefix + to_string(i) + " = " + init;
+
+                // Wrap the list every few variables, as a declaration can span multiple lines
+                if (i + 1 == width) {
+                    line(decl + ";");
+                } else if (i % 8 == 7) {
+                    line(decl + ",");
+                    decl = "    ";
+                } else {
+                    decl += ", ";
+                }
+            }
+
+            if (!global) {
+                line("return " + prefix + to_string(width - 1) + ";");
+                line("}");
+            }
+
+            line("");
+        }
+
+        line("int main() {");
+        line("return d1(1);");
+        line("}");
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,518 @@
+#ifndef __COMPILE_CONTEXT_H_
+#define __COMPILE_CONTEXT_H_
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "scope_context.h"
+#include "generation_context.h"
+
+#include "../parse_tree/parse_tree.h"
+#include "../quadruples/quad_writer.h"
+#include "../utils/arena.h"
+#include "../utils/parallel.h"
+#include "../utils/source_buffer.h"
+#include "../utils/time_report.h"
+#include "../utils/utils.h"
+
+using namespace std;
+
+//
+// Parser Options
+//
+#ifndef PARSER_MAX_DEPTH
+#define PARSER_MAX_DEPTH    (1 << 22)   // The default maximum depth of the parser stacks
+#endif
+
+class CompileContext;
+
+//
+// External functions of the reentrant lexer & parser
+//
+extern int yylex_init_extra(CompileContext* extra, void** scanner);
+extern int yylex_destroy(void* scanner);
+extern int yyparse(void* scanner, CompileContext* context);
+
+
+/**
+ * Struct holding a top-level statement of the program along with its analysis and generation results.
+ *
+ * The bodies of top-level functions are analyzed and generated independently of each other,
+ * and their results are combined in the order of the source code.
+ */
+struct TopLevelUnit {
+    StatementNode* stmt;                            // The top-level statement
+    FunctionNode* func = NULL;                      // The statement if it is a function, or NULL
+    int visibleGlobals = 0;                         // The number of global symbols declared up to this statement
+    bool ret = true;                                // Whether the statement is semantically valid or not
+    Diagnostics diagnostics;                        // The diagnostics of the statement
+    GlobalEffects effects;                          // The effects of the statement on global variables
+    vector<pair<int, DeclarationNode*>> symbols;    // The symbols declared by the statement
+    QuadProcBuffer quads;                           // The generated procedures of the function
+};
+
+/**
+ * Class holding the whole state of a single compilation.
+ *
+ * The lexer, the parser and the later phases keep no global state of their own,
+ * so independent compile contexts can be used concurrently from different threads.
+ * Each compilation interns its identifiers into its own table, so that the handles
+ * (and the tables indexed by them) depend only on the file being compiled.
+ *
+ * The parser hands each top-level statement to this context as soon as it is reduced.
+ * The statements are either collected into the parse tree of the whole program,
+ * or compiled and released right away when streaming (see {@code parse}).
+ */
+class CompileContext {
+public:
+    string sourceFilename;
+    SourceBuffer source;                // The source code, read by the lexer and quoted by the diagnostics
+    InternTable interns;                // The identifiers and token texts of this compilation, see ScopeContext
+    Arena arena;                        // The arena holding the parse tree nodes and lists
+    StatementNode* programRoot = NULL;  // The root of the parse tree, set by the parser
+    Location curLoc = {1, 0, 0};        // The current location of the lexer in the source code
+
+    Diagnostics diagnostics;            // The diagnostics of this compilation, emitted when it ends
+    ScopeContext scopeContext;
+    GenerationContext genContext;
+
+    bool keepSymbols = true;            // Whether to keep the local symbols in the symbol table when streaming
+    int maxParseDepth = PARSER_MAX_DEPTH;   // The maximum depth of the parser stacks, bounding the nesting level
+    TimeReport* timeReport = NULL;      // The report measuring the phases of this compilation, or NULL
+
+private:
+    vector<TopLevelUnit> units;
+    StmtList statements;                // The top-level statements parsed so far, unless streaming
+
+    QuadWriter* streamWriter = NULL;    // The output sink of the top-level statements when streaming, or NULL
+    bool streamValid = true;            // Whether the statements streamed so far are semantically valid
+    bool bodyMarked = false;            // Whether the body of a top-level function is being parsed
+    Arena::Mark bodyMark;               // The position in the arena where the body of the function begins
+
+public:
+
+    /**
+     * Constructs a new compile context object.
+     *
+     * @param sourceFilename the filename of the source code to compile.
+     * @param warn           whether to show warning messages or not.
+     */
+    CompileContext(const string& sourceFilename, bool warn = false)
+            : sourceFilename(sourceFilename), diagnostics(sourceFilename),
+              scopeContext(&interns, warn), genContext(&interns) {
+        scopeContext.setDiagnostics(&diagnostics);
+    }
+
+    CompileContext(const CompileContext&) = delete;
+
+    CompileContext& operator=(const CompileContext&) = delete;
+
+    /**
+     * Parses the source code file of this compilation, storing its parse tree in {@code programRoot}.
+     * The file is loaded once into {@code source}, which the lexer reads and the diagnostics quote.
+     *
+     * If an output sink is given, the program is compiled while parsing instead:
+     * each top-level statement is analyzed, generated into the output sink and released
+     * as soon as it is parsed, so that the memory held depends on the largest function rather than the file size.
+     * Only the global declarations are kept, as the global scope persists across the statements.
+     * The generation stops at the first invalid statement (see {@code isStreamValid}).
+     *
+     * @param writer the output sink to compile the top-level statements into, or {@code NULL} to only parse them.
+     *
+     * @return {@code true} if the source file was parsed, {@code false} if it could not be opened.
+     */
+    bool parse(QuadWriter* writer = NULL) {
+        if (!source.open(sourceFilename)) {
+            return false;
+        }
+
+        if (writer != NULL) {
+            streamWriter = writer;
+            streamValid = true;
+            programRoot = arena.make<BlockNode>();
+            scopeContext.addScope(SCOPE_BLOCK, programRoot);
+            genContext.setWriter(writer);
+        }
+
+        enterPhase(PHASE_PARSE);
+
+        void* scanner;
+        yylex_init_extra(this, &scanner);
+
+        // The program is invalid if the parser could not recover from a syntax error,
+        // or if the source code is nested too deeply for the parser stacks
+        int ret = yyparse(scanner, this);
+
+        if (ret != 0) {
+            streamValid = false;
+        }
+        if (ret == 2) {
+            scopeContext.log("nesting too deep, exceeding the parser depth limit of " + to_string(maxParseDepth),
+                             curLoc, LOG_ERROR);
+        }
+
+        yylex_destroy(scanner);
+
+        if (writer != NULL) {
+            enterPhase(PHASE_GENERATE);
+            genContext.flush();
+            genContext.setWriter(NULL);
+
+            // Close the global scope, reporting the unused global symbols
+            enterPhase(PHASE_ANALYZE);
+            scopeContext.popScope();
+            streamWriter = NULL;
+        }
+
+        return true;
+    }
+
+    /**
+     * Returns whether the top-level statements compiled while parsing are semantically valid.
+     */
+    bool isStreamValid() const {
+        return streamValid;
+    }
+
+    /**
+     * Called by the parser when the header of a function is reduced, before parsing its body.
+     */
+    void beginFunctionBody() {
+        // Only the outer most function is released, along with any function nested in it
+        if (streamWriter != NULL && !bodyMarked) {
+            bodyMark = arena.mark();
+            bodyMarked = true;
+        }
+    }
+
+    /**
+     * Called by the parser when a top-level statement is reduced.
+     *
+     * @param stmt the top-level statement.
+     */
+    void addStatement(StatementNode* stmt) {
+        if (streamWriter == NULL) {
+            statements.push_back(stmt);
+            return;
+        }
+
+        size_t begin = scopeContext.getSymbols().size();
+
+        enterPhase(PHASE_ANALYZE);
+        streamValid &= stmt->analyze(&scopeContext);
+
+        if (streamValid) {
+            enterPhase(PHASE_GENERATE);
+            stmt->generateQuad(&genContext);
+        }
+
+        // Release the body of a function, keeping its header along with the global declarations
+        FunctionNode* func = nodeCast<FunctionNode>(stmt);
+
+        if (func != NULL && bodyMarked) {
+            scopeContext.retireSymbols(begin, keepSymbols);
+            func->body = NULL;
+            arena.rewind(bodyMark);
+        }
+
+        bodyMarked = false;
+        enterPhase(PHASE_PARSE);
+    }
+
+    /**
+     * Called by the parser at the end of the program.
+     */
+    void endProgram() {
+        if (streamWriter != NULL) {
+            return;
+        }
+
+        if (statements.empty()) {
+            programRoot = arena.make<BlockNode>();
+        } else {
+            programRoot = arena.make<BlockNode>(statements[0]->loc, statements);
+        }
+
+        statements.clear();
+    }
+
+    /**
+     * Applies the semantic checks on the parse tree of this compilation.
+     *
+     * The global declarations are analyzed first in order, then the bodies of the functions
+     * are analyzed concurrently, each in its own forked scope context and diagnostics buffer.
+     * The results are combined in the order of the source code, so that they do not depend on the number of threads.
+     *
+     * @param threads the number of threads to analyze the functions on.
+     *
+     * @return {@code true} if the program is semantically valid; {@code false} otherwise.
+     */
+    bool analyze(int threads) {
+        if (programRoot == NULL) {
+            return false;
+        }
+
+        BlockNode* root = (BlockNode*) programRoot;
+        Diagnostics* log = scopeContext.getDiagnostics();
+
+        enterPhase(PHASE_ANALYZE);
+        units = vector<TopLevelUnit>(root->statements.size());
+
+        // Declare the global symbols in order, including the functions without their bodies
+        scopeContext.trackGlobals = true;
+        scopeContext.addScope(SCOPE_BLOCK, root);
+
+        for (int i = 0; i < units.size(); ++i) {
+            TopLevelUnit& unit = units[i];
+            unit.stmt = root->statements[i];
+            unit.func = nodeCast<FunctionNode>(unit.stmt);
+
+            size_t begin = scopeContext.getSymbols().size();
+            scopeContext.setDiagnostics(&unit.diagnostics);
+
+            if (unit.func != NULL) {
+                unit.ret = unit.func->declare(&scopeContext);
+            } else {
+                unit.ret = unit.stmt->analyze(&scopeContext);
+            }
+
+            unit.visibleGlobals = scopeContext.getGlobalCount();
+            unit.effects = scopeContext.takeGlobalEffects();
+            unit.symbols.assign(scopeContext.getSymbols().begin() + begin, scopeContext.getSymbols().end());
+        }
+
+        // Analyze the function bodies concurrently, reusing a forked context in each worker thread
+        vector<unique_ptr<ScopeContext>> forks(max(threads, 1));
+
+        parallelFor(units.size(), threads, [&](size_t i, int worker) {
+            TopLevelUnit& unit = units[i];
+
+            if (unit.func == NULL) {
+                return;
+            }
+
+            if (!forks[worker]) {
+                forks[worker].reset(scopeContext.fork());
+            }
+
+            ScopeContext* fork = forks[worker].get();
+            fork->setDiagnostics(&unit.diagnostics);
+            fork->setVisibleGlobals(unit.visibleGlobals);
+
+            unit.ret &= unit.func->analyzeBody(fork);
+            unit.effects = fork->takeGlobalEffects();
+            unit.symbols.insert(unit.symbols.end(), fork->getSymbols().begin(), fork->getSymbols().end());
+            fork->getSymbols().clear();
+        });
+
+        // Combine the results in order, resolving the reads of global variables assigned by earlier functions
+        unordered_set<DeclarationNode*> initialized;
+        vector<pair<int, DeclarationNode*>>& symbols = scopeContext.getSymbols();
+        bool ret = true;
+
+        symbols.clear();
+
+        for (int i = 0; i < units.size(); ++i) {
+            TopLevelUnit& unit = units[i];
+            size_t pos = 0;
+
+            for (int j = 0; j < unit.effects.checks.size(); ++j) {
+                const DeferredCheck& check = unit.effects.checks[j];
+
+                if (initialized.count(check.sym) > 0) {
+                    continue;
+                }
+
+                log->append(unit.diagnostics, pos, check.logIndex);
+                pos = check.logIndex;
+
+                log->add(LOG_ERROR, ScopeContext::uninitializedMessage(check.sym), check.loc);
+                unit.ret = false;
+            }
+
+            log->append(unit.diagnostics, pos, unit.diagnostics.size());
+
+            initialized.insert(unit.effects.initialized.begin(), unit.effects.initialized.end());
+            symbols.insert(symbols.end(), unit.symbols.begin(), unit.symbols.end());
+            ret &= unit.ret;
+
+            unit.diagnostics.clear();
+            unit.effects = GlobalEffects();
+            unit.symbols.clear();
+        }
+
+        for (DeclarationNode* sym : initialized) {
+            sym->initialized = true;
+        }
+
+        // Close the global scope, reporting the unused global symbols
+        scopeContext.setDiagnostics(log);
+        scopeContext.trackGlobals = false;
+        scopeContext.popScope();
+
+        return ret;
+    }
+
+    /**
+     * Generates the quadruples of the analyzed parse tree of this compilation into the given output sink.
+     *
+     * The functions are generated concurrently, each in its own generation context and namespace of labels,
+     * then written into the output sink in the order of the source code along with the global code.
+     *
+     * @param writer  the output sink to write the generated procedures into.
+     * @param threads the number of threads to generate the functions on.
+     */
+    void generate(QuadWriter* writer, int threads) {
+        enterPhase(PHASE_GENERATE);
+
+        parallelFor(units.size(), threads, [&](size_t i, int worker) {
+            if (units[i].func != NULL) {
+                GenerationContext context(&interns, &units[i].quads);
+                units[i].func->generateQuad(&context);
+            }
+        });
+
+        genContext.setWriter(writer);
+
+        for (int i = 0; i < units.size(); ++i) {
+            TopLevelUnit& unit = units[i];
+
+            if (unit.func == NULL) {
+                unit.stmt->generateQuad(&genContext);
+                continue;
+            }
+
+            genContext.flush();
+
+            for (int j = 0; j < unit.quads.procs.size(); ++j) {
+                writer->write(unit.quads.procs[j]);
+            }
+
+            unit.quads.procs.clear();
+        }
+
+        genContext.flush();
+        genContext.setWriter(NULL);
+    }
+
+    /**
+     * Applies the semantic checks and generates the quadruples of the parse tree of this compilation
+     * in a single traversal of the tree, as an alternative to calling {@code analyze} then {@code generate}.
+     *
+     * Each top-level statement is generated right after it is analyzed, while its nodes are still in the cache,
+     * and its procedures are written into the output sink instead of being buffered until the end.
+     * A whole top-level statement is analyzed before generating it, since some nodes need information
+     * gathered from later nodes (e.g. the case labels of a switch statement).
+     * The statements are compiled sequentially in the order of the source code.
+     *
+     * @param writer the output sink to write the generated procedures into.
+     *
+     * @return {@code true} if the program is semantically valid; {@code false} otherwise,
+     *         in which case the generation stops at the first invalid statement.
+     */
+    bool compile(QuadWriter* writer) {
+        if (programRoot == NULL) {
+            return false;
+        }
+
+        BlockNode* root = (BlockNode*) programRoot;
+        bool ret = true;
+
+        scopeContext.addScope(SCOPE_BLOCK, root);
+        genContext.setWriter(writer);
+
+        for (int i = 0; i < root->statements.size(); ++i) {
+            StatementNode* stmt = root->statements[i];
+
+            enterPhase(PHASE_ANALYZE);
+            ret &= stmt->analyze(&scopeContext);
+
+            if (ret) {
+                enterPhase(PHASE_GENERATE);
+                stmt->generateQuad(&genContext);
+            }
+        }
+
+        genContext.flush();
+        genContext.setWriter(NULL);
+
+        // Close the global scope, reporting the unused global symbols
+        enterPhase(PHASE_ANALYZE);
+        scopeContext.popScope();
+
+        return ret;
+    }
+
+    /**
+     * Starts measuring the given phase of this compilation, if a time report is attached.
+     *
+     * @param phase the phase to measure, or -1 to stop measuring.
+     * @param exact whether to sample the CPU time and the peak memory as well (see {@code TimeReport::enter}).
+     */
+    void enterPhase(int phase, bool exact = true) {
+        if (timeReport != NULL) {
+            timeReport->enter(phase, exact);
+        }
+    }
+
+    /**
+     * Returns the phase of this compilation being measured, or -1 if none or if no time report is attached.
+     */
+    int currentPhase() const {
+        return timeReport != NULL ? timeReport->phase() : -1;
+    }
+
+    /**
+     * Releases the parse tree of this compilation at once.
+     */
+    void release() {
+        units.clear();
+        statements.clear();
+        programRoot = NULL;
+        arena.release();
+    }
+};
+
+/**
+ * Output sink charging the time spent in another sink to the output phase of a compilation.
+ *
+ * The procedures are formatted and written by the final sink while they are being generated,
+ * so this sink switches to the output phase around each call and then resumes the interrupted phase.
+ * Only {@code finish} samples the CPU time, as the procedures may be written as often as they are generated.
+ */
+class PhaseWriter : public QuadWriter {
+private:
+    CompileContext* compilation;
+    QuadWriter* next;
+
+public:
+
+    /**
+     * Constructs a new output phase sink.
+     *
+     * @param compilation the compilation to charge the output to.
+     * @param next        the sink to forward the procedures to.
+     */
+    PhaseWriter(CompileContext* compilation, QuadWriter* next) : compilation(compilation), next(next) {
+
+    }
+
+    virtual void write(const QuadProc& proc) {
+        int phase = compilation->currentPhase();
+        compilation->enterPhase(PHASE_OUTPUT, false);
+        next->write(proc);
+        compilation->enterPhase(phase, false);
+    }
+
+    virtual void finish() {
+        int phase = compilation->currentPhase();
+        compilation->enterPhase(PHASE_OUTPUT);
+        next->finish();
+        compilation->enterPhase(phase);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -7,11 +7,25 @@
 #include <stack>
 #include <map>
 
+#include "../parse_tree/parse_tree.h"
+#include "../quadruples/quadruple.h"
+#include "../quadruples/quad_writer.h"
+
+#include "../utils/utils.h"
+#include "../utils/consts.h"
+
 using namespace std;
 
 
 /**
  * Class holding the current context in the quadruple generation phase.
+ *
+ * The generated quadruples are collected into the procedure currently being generated,
+ * which is handed to the output sink of this context (a text serializer, a binary writer, ...)
+ * as soon as it is completed.
+ *
+ * Each function has its own namespace of labels, numbered from one,
+ * so that the labels of a function do not depend on the functions generated before it.
  */
 class GenerationContext {
 public:
@@ -20,9 +34,199 @@ public:
 
 	bool declareFuncParams;
 
-    GenerationContext() {
+    InternTable* interns;       // The intern table of the compilation
+
+private:
+    QuadWriter* writer;
+    QuadProc proc;
+    int globalLabelCounter;     // The label counter of the global code, saved while generating a function
+
+public:
+
+    /**
+     * Constructs a new generation context object.
+     *
+     * @param interns the intern table of the compilation.
+     * @param writer  the output sink to write the generated procedures into.
+     */
+    GenerationContext(InternTable* interns, QuadWriter* writer = NULL) {
         labelCounter = 1;
+        globalLabelCounter = 1;
 		declareFuncParams = false;
+        this->interns = interns;
+        this->writer = writer;
+    }
+
+    /**
+     * Sets the output sink of this context.
+     *
+     * @param writer the output sink to write the generated procedures into.
+     */
+    void setWriter(QuadWriter* writer) {
+        this->writer = writer;
+    }
+
+    /**
+     * Emits a quadruple instruction having no operands (e.g. {@code ADD_INT}).
+     *
+     * @param loc  the location of the source code generating the instruction.
+     * @param opr  the operator of the instruction.
+     * @param type the data type of the instruction.
+     */
+    void emitOpr(const Location& loc, Operator opr, DataType type = DTYPE_UNKNOWN) {
+        proc.quads.push_back(Quad(loc, opr, type));
+    }
+
+    /**
+     * Emits a quadruple instruction operating on a declared symbol (e.g. {@code PUSH_INT x@1}).
+     *
+     * @param loc  the location of the source code generating the instruction.
+     * @param opr  the operator of the instruction.
+     * @param type the data type of the instruction.
+     * @param sym  the declaration node of the symbol.
+     */
+    void emitSymbol(const Location& loc, Operator opr, DataType type, DeclarationNode* sym) {
+        emitSymbol(loc, opr, type, sym->alias, sym->global);
+    }
+
+    /**
+     * Emits a quadruple instruction operating on a symbol (e.g. {@code POP_INT SWITCH_COND@1}).
+     *
+     * @param loc    the location of the source code generating the instruction.
+     * @param opr    the operator of the instruction.
+     * @param type   the data type of the instruction.
+     * @param alias  the interned alias name of the symbol.
+     * @param global whether the symbol is declared in the global scope or not.
+     */
+    void emitSymbol(const Location& loc, Operator opr, DataType type, InternId alias, bool global = false) {
+        Quad q(loc, opr, type);
+        q.operand.kind = OPERAND_SYMBOL;
+        q.operand.symbol = proc.getSlot(alias, *interns, global);
+        proc.quads.push_back(q);
+    }
+
+    /**
+     * Emits a push instruction of an immediate value (e.g. {@code PUSH_INT 5}).
+     *
+     * @param loc   the location of the source code generating the instruction.
+     * @param type  the data type of the value.
+     * @param value the value to push.
+     */
+    void emitValue(const Location& loc, DataType type, const Value& value) {
+        Quad q(loc, OPR_PUSH, type);
+        q.operand.kind = OPERAND_VALUE;
+        q.operand.value = value;
+        proc.quads.push_back(q);
+    }
+
+    /**
+     * Emits a jump instruction to the given label (e.g. {@code JZ_BOOL L1}).
+     *
+     * @param loc   the location of the source code generating the instruction.
+     * @param opr   the jump operator.
+     * @param label the label to jump to.
+     * @param type  the data type of the condition, if any.
+     */
+    void emitJump(const Location& loc, Operator opr, int label, DataType type = DTYPE_UNKNOWN) {
+        Quad q(loc, opr, type);
+        q.operand.kind = OPERAND_LABEL;
+        q.operand.label = label;
+        proc.quads.push_back(q);
+    }
+
+    /**
+     * Emits a label definition (e.g. {@code L1:}).
+     *
+     * @param loc   the location of the source code generating the label.
+     * @param label the label to define.
+     */
+    void emitLabel(const Location& loc, int label) {
+        emitJump(loc, OPR_LABEL, label);
+    }
+
+    /**
+     * Emits a data type conversion instruction, if the two types are different.
+     *
+     * If the converted value is an immediate value that has just been pushed,
+     * the value itself is converted instead.
+     *
+     * @param loc the location of the source code generating the instruction.
+     * @param t1  the type to convert from.
+     * @param t2  the type to convert to.
+     */
+    void emitConv(const Location& loc, DataType t1, DataType t2) {
+        if (t1 == t2) {
+            return;
+        }
+
+        if (!proc.quads.empty()) {
+            Quad& last = proc.quads.back();
+
+            if (last.opr == OPR_PUSH && last.operand.kind == OPERAND_VALUE && last.type == t1) {
+                last.operand.value = Utils::convertValue(last.operand.value, t1, t2);
+                last.type = t2;
+                return;
+            }
+        }
+
+        Quad q(loc, OPR_CONV, t1);
+        q.operand.kind = OPERAND_TYPE;
+        q.operand.type = t2;
+        proc.quads.push_back(q);
+    }
+
+    /**
+     * Emits a function call instruction.
+     *
+     * @param loc  the location of the source code generating the instruction.
+     * @param func the function to call.
+     */
+    void emitCall(const Location& loc, FunctionNode* func) {
+        emitSymbol(loc, OPR_CALL, DTYPE_UNKNOWN, func);
+    }
+
+    /**
+     * Emits a function return instruction.
+     *
+     * @param loc the location of the source code generating the instruction.
+     */
+    void emitRet(const Location& loc) {
+        emitOpr(loc, OPR_RET);
+    }
+
+    /**
+     * Starts a new procedure for the given function,
+     * after flushing any pending global code.
+     *
+     * @param func the function of the procedure.
+     */
+    void beginProc(FunctionNode* func) {
+        flush();
+        proc.name = interns->str(func->alias);
+        globalLabelCounter = labelCounter;
+        labelCounter = 1;
+    }
+
+    /**
+     * Completes the current procedure and writes it into the output sink.
+     */
+    void endProc() {
+        writer->write(proc);
+
+        if (!proc.name.empty()) {
+            labelCounter = globalLabelCounter;
+        }
+
+        proc.clear();
+    }
+
+    /**
+     * Writes any pending global code into the output sink.
+     */
+    void flush() {
+        if (!proc.quads.empty()) {
+            endProc();
+        }
     }
 };
 
@@ -2,41 +2,82 @@
 #define __CONTEXT_H_
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <string>
 #include <vector>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "../parse_tree/parse_tree.h"
+#include "symbol_table_writer.h"
 
+#include "../utils/diagnostics.h"
 #include "../utils/utils.h"
 #include "../utils/consts.h"
 
 using namespace std;
 
 
-/**
- * Symbol table type.
- */
-typedef unordered_map<string, DeclarationNode*> SymbolTable;
-
 /**
  * Struct holding scope information.
+ *
+ * The enclosing function, switch and loops are tracked in each scope,
+ * so that they are queried in constant time regardless of the nesting depth.
  */
 struct Scope {
-    ScopeType type;         // The type of the scope
-    Node* ptr;              // A pointer to the node of the scope
-    SymbolTable table;      // The symbol table of this scope
+    ScopeType type;             // The type of the scope
+    Node* ptr;                  // A pointer to the node of the scope
+    vector<InternId> declared;  // The identifiers declared in this scope in declaration order, undone when popped
+    FunctionNode* function;     // The inner most enclosing function scope, or NULL
+    SwitchNode* switchStmt;     // The inner most enclosing switch scope, or NULL
+    int loopCount;              // The number of enclosing loop scopes
 
     Scope(ScopeType type, Node* ptr = NULL) {
         this->type = type;
         this->ptr = ptr;
+        this->function = NULL;
+        this->switchStmt = NULL;
+        this->loopCount = 0;
     }
 };
 
+/**
+ * Struct holding a live declaration of an identifier.
+ */
+struct Binding {
+    int depth;                  // The index of the scope of the declaration
+    int order;                  // The number of global declarations preceding this one, if global
+    DeclarationNode* sym;       // The declaration node
+
+    Binding(int depth, int order, DeclarationNode* sym) {
+        this->depth = depth;
+        this->order = order;
+        this->sym = sym;
+    }
+};
+
+/**
+ * Struct holding a read of a global variable whose initialization is not known yet.
+ */
+struct DeferredCheck {
+    DeclarationNode* sym;       // The global variable
+    Location loc;               // The location of the read
+    size_t logIndex;            // The index in the diagnostics buffer to insert the error message at
+};
+
+/**
+ * Struct holding the effects of a top-level statement on the initialization of global variables.
+ *
+ * Global variables declared without a value may be assigned by any function,
+ * so whether a read is initialized depends on all the statements before it.
+ * These effects let the top-level statements be analyzed independently,
+ * then resolved in the order of the source code.
+ */
+struct GlobalEffects {
+    unordered_set<DeclarationNode*> initialized;    // The global variables assigned by the statement
+    vector<DeferredCheck> checks;                   // The reads of global variables not assigned by the statement
+};
+
 /**
  * Class holding the current context in the semantic analyzing phase.
  */
@@ -45,34 +86,79 @@ private:
     //
     // Private member variables
     //
-    string sourceFilename;
-    vector<string> sourceCode;
-    vector<Scope*> scopes;
-    unordered_map<string, int> aliases;
+    vector<Scope> scopes;
+    InternTable* interns;                           // The intern table of the compilation
+    vector<vector<Binding>> bindings;               // The stack of live declarations of each identifier, indexed by its interned name
     vector<pair<int, DeclarationNode*>> symbols;    // Used just for printing the symbol table. NOT IMPORTANT!
+    vector<SymbolEntry> retiredSymbols;             // The symbol table entries of the retired symbols, see retireSymbols
+    Diagnostics* diagnostics = NULL;                // The buffer to collect the diagnostics into
     bool warn;
 
+    const ScopeContext* parent = NULL;              // The context this function context is forked from, or NULL
+    int globalCount = 0;                            // The number of global declarations in this context, or visible from the parent
+    GlobalEffects effects;                          // The effects of the current top-level statement on global variables
+
 public:
     //
     // Public member variables
     //
     bool declareFuncParams = false;
     bool initializeVar = false;
+    bool trackGlobals = false;                      // Whether to track the effects on global variables instead of applying them
 
 public:
 
     /**
      * Constructs a new context object.
      *
-     * @param sourceFilename the filename of the source code to compile.
-     * @param warn           whether to show warning messages or not.
+     * The identifiers are interned into the table of the compilation, whose handles are dense
+     * over the strings of this compilation only, so that the bindings are indexed by them directly.
+     *
+     * @param interns the intern table of the compilation.
+     * @param warn    whether to show warning messages or not.
      */
-    ScopeContext(const string& sourceFilename, bool warn = false) {
-        this->sourceFilename = sourceFilename;
-        this->readSourceCode();
+    ScopeContext(InternTable* interns, bool warn) {
+        this->interns = interns;
         this->warn = warn;
     }
 
+    /**
+     * Forks a new context to analyze the bodies of top-level functions in,
+     * independently of the other functions.
+     *
+     * The forked context sees the first global symbols declared in this context (see {@code setVisibleGlobals}),
+     * and tracks its effects on the global variables instead of applying them.
+     * This context must not declare new symbols while the forked context is in use.
+     *
+     * @return the forked context, owned by the caller.
+     */
+    ScopeContext* fork() const {
+        ScopeContext* ret = new ScopeContext();
+        ret->interns = interns;
+        ret->warn = warn;
+        ret->parent = this;
+        ret->trackGlobals = true;
+        ret->scopes.push_back(Scope(scopes[0].type, scopes[0].ptr));
+        return ret;
+    }
+
+    /**
+     * Sets the number of the first global symbols of the parent context that are visible to this forked context,
+     * that is, the global symbols declared before the function being analyzed (including itself).
+     *
+     * @param count the number of visible global symbols.
+     */
+    void setVisibleGlobals(int count) {
+        globalCount = count;
+    }
+
+    /**
+     * Returns the number of global symbols declared in this context so far.
+     */
+    int getGlobalCount() const {
+        return globalCount;
+    }
+
     /**
      * Adds a new scope to this context.
      *
@@ -80,32 +166,51 @@ public:
      * @param ptr  a pointer to the node of the scope in the parse tree.
      */
     void addScope(ScopeType type, Node* ptr = NULL) {
-        scopes.push_back(new Scope(type, ptr));
+        Scope scope(type, ptr);
+
+        if (!scopes.empty()) {
+            scope.function = scopes.back().function;
+            scope.switchStmt = scopes.back().switchStmt;
+            scope.loopCount = scopes.back().loopCount;
+        }
+
+        switch (type) {
+            case SCOPE_FUNCTION:
+                scope.function = (FunctionNode*) ptr;
+                break;
+            case SCOPE_SWITCH:
+                scope.switchStmt = (SwitchNode*) ptr;
+                break;
+            case SCOPE_LOOP:
+                scope.loopCount++;
+                break;
+        }
+
+        scopes.push_back(scope);
     }
 
     /**
      * Removes the lastly added scope from this context.
      */
     void popScope() {
-        Scope* scope = scopes.back();
-        scopes.pop_back();
+        const Scope& scope = scopes.back();
 
-        for (auto& it : scope->table) {
-            DeclarationNode* sym = it.second;
+        // Unwind the declarations of the scope
+        for (int i = 0; i < scope.declared.size(); ++i) {
+            DeclarationNode* sym = bindings[scope.declared[i]].back().sym;
+            bindings[scope.declared[i]].pop_back();
 
             if (sym->used <= 0) {
-                if (dynamic_cast<VarDeclarationNode*>(sym)) {
+                if (sym->kind == NODE_VAR_DECL) {
                     log("the value of variable '" + sym->declaredHeader() + "' is never used", sym->ident->loc, LOG_WARNING);
                 }
                 else if (sym->ident->name != "main") {
                     log("function '" + sym->declaredHeader() + "' is never called", sym->ident->loc, LOG_WARNING);
                 }
             }
-            
-            aliases[sym->ident->name]--;
         }
 
-        delete scope;
+        scopes.pop_back();
     }
 
     /**
@@ -123,13 +228,7 @@ public:
      * @return a pointer on the found function scope, or {@code NULL} if not available.
      */
     FunctionNode* getFunctionScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_FUNCTION) {
-                return (FunctionNode*) scopes[i]->ptr;
-            }
-        }
-
-        return NULL;
+        return scopes.back().function;
     }
 
     /**
@@ -138,13 +237,7 @@ public:
      * @return a pointer on the found switch scope, or {@code NULL} if not available.
      */
     SwitchNode* getSwitchScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_SWITCH) {
-                return (SwitchNode*) scopes[i]->ptr;
-            }
-        }
-
-        return NULL;
+        return scopes.back().switchStmt;
     }
 
     /**
@@ -155,43 +248,120 @@ public:
      * @return {@code true} if the symbol was declared successfully; {@code false} if already declared.
      */
     bool declareSymbol(DeclarationNode* sym) {
-        SymbolTable& table = scopes.back()->table;
+        InternId id = sym->ident->id;
+        int depth = (int) scopes.size() - 1;
 
-        if (table.count(sym->ident->name)) {
+        if (id >= bindings.size()) {
+            bindings.resize(id + 1);
+        }
+
+        vector<Binding>& stack = bindings[id];
+
+        if (!stack.empty() && stack.back().depth == depth) {
             return false;
         }
 
         // Add symbol for later printing
-        symbols.push_back({ scopes.size() - 1, sym });
+        symbols.push_back({ depth, sym });
 
-        // Form a new alias name for the identifier
-        int num = aliases[sym->ident->name]++;
+        // Form a new alias name for the identifier, numbered by the count of its shadowed declarations
+        int num = (int) stack.size();
+
+        if (parent != NULL && parent->getGlobalSymbol(id, globalCount) != NULL) {
+            num++;
+        }
 
         if (num > 0) {
-            sym->alias = sym->ident->name + "@" + to_string(num);
+            sym->alias = interns->intern(sym->ident->name + "@" + to_string(num));
         } else {
-            sym->alias = sym->ident->name;
+            sym->alias = sym->ident->id;
         }
 
-        table[sym->ident->name] = sym;
+        sym->global = isGlobalScope();
+
+        stack.push_back(Binding(depth, sym->global && parent == NULL ? globalCount++ : -1, sym));
+        scopes.back().declared.push_back(id);
         return true;
     }
 
     /**
      * Searches for the given identifier in the symbol table.
      *
-     * @param identifier the name of the symbol to search for.
+     * @param identifier the interned name of the symbol to search for.
      *
      * @return a pointer on the found symbol table entry, or {@code NULL} if not available.
      */
-    DeclarationNode* getSymbol(const string& identifier) {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->table.count(identifier)) {
-                return scopes[i]->table[identifier];
-            }
+    DeclarationNode* getSymbol(InternId identifier) {
+        if (identifier < bindings.size() && !bindings[identifier].empty()) {
+            return bindings[identifier].back().sym;
+        }
+
+        return parent ? parent->getGlobalSymbol(identifier, globalCount) : NULL;
+    }
+
+    /**
+     * Checks whether the given variable is initialized at this point of the analysis,
+     * and logs an error if not.
+     *
+     * If the variable is a global one declared without a value, and global effects are tracked,
+     * the check is deferred until the statements before the current one are known,
+     * and the variable is considered initialized for now.
+     *
+     * @param sym the variable to check.
+     * @param loc the location of the token reading the variable.
+     *
+     * @return {@code true} if the variable is initialized or the check is deferred; {@code false} otherwise.
+     */
+    bool checkInitialized(DeclarationNode* sym, const Location& loc) {
+        if (sym->initialized) {
+            return true;
+        }
+
+        if (!sym->global || !trackGlobals) {
+            log(uninitializedMessage(sym), loc, LOG_ERROR);
+            return false;
+        }
+
+        if (effects.initialized.count(sym) == 0) {
+            effects.checks.push_back({ sym, loc, diagnostics->size() });
+        }
+
+        return true;
+    }
+
+    /**
+     * Formats the error message of reading the given uninitialized variable.
+     *
+     * @param sym the variable read.
+     *
+     * @return the error message.
+     */
+    static string uninitializedMessage(DeclarationNode* sym) {
+        return "variable or field '" + sym->ident->name + "' used without being initialized";
+    }
+
+    /**
+     * Marks the given variable as initialized.
+     *
+     * @param sym the variable to mark.
+     */
+    void markInitialized(DeclarationNode* sym) {
+        if (sym->global && trackGlobals) {
+            effects.initialized.insert(sym);
+        } else {
+            sym->initialized = true;
         }
+    }
 
-        return NULL;
+    /**
+     * Returns the tracked effects on global variables since the last call, and resets them.
+     *
+     * @return the tracked effects.
+     */
+    GlobalEffects takeGlobalEffects() {
+        GlobalEffects ret;
+        swap(ret, effects);
+        return ret;
     }
 
     /**
@@ -201,13 +371,7 @@ public:
      * @return {@code true} if this context has a break scope, {@code false} otherwise.
      */
     bool hasBreakScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_LOOP || scopes[i]->type == SCOPE_SWITCH) {
-                return true;
-            }
-        }
-
-        return false;
+        return scopes.back().loopCount > 0 || scopes.back().switchStmt != NULL;
     }
 
     /**
@@ -217,13 +381,7 @@ public:
      * @return {@code true} if this context has a switch scope, {@code false} otherwise.
      */
     bool hasSwitchScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_SWITCH) {
-                return true;
-            }
-        }
-
-        return false;
+        return scopes.back().switchStmt != NULL;
     }
 
     /**
@@ -233,13 +391,7 @@ public:
      * @return {@code true} if this context has a continue scope, {@code false} otherwise.
      */
     bool hasLoopScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_LOOP) {
-                return true;
-            }
-        }
-
-        return false;
+        return scopes.back().loopCount > 0;
     }
 
     /**
@@ -249,104 +401,129 @@ public:
      * @return {@code true} if this context has a continue scope, {@code false} otherwise.
      */
     bool hasFunctionScope() {
-        for (int i = (int) scopes.size() - 1; i >= 0; --i) {
-            if (scopes[i]->type == SCOPE_FUNCTION) {
-                return true;
-            }
-        }
-
-        return false;
+        return scopes.back().function != NULL;
     }
 
     /**
-     * Logs the given message at the given location in this context.
+     * Logs the given message at the given location in this context,
+     * collecting it into the diagnostics buffer of this context.
      *
      * @param what  the message to log.
      * @param loc   the location of the token to point upon in this context.
      * @param level the log level of this message.
      */
     void log(const string& what, const Location& loc, LogLevel level) {
-        string logLvl;
-
-        switch (level) {
-            // In future we may change the output stream of each level
-            // and change th colors of the log level and the intended token
-            case LOG_ERROR:
-                logLvl = "error";
-                break;
-            case LOG_WARNING:
-                if (!warn) {
-                    // Suppress  warnings
-                    return;
-                }
-                logLvl = "warning";
-                break;
-            case LOG_NOTE:
-                logLvl = "note";
-                break;
+        if (level == LOG_WARNING && !warn) {
+            // Suppress warnings
+            return;
         }
 
-        fprintf(stdout, "%s:%d:%d: %s: %s\n", sourceFilename.c_str(), loc.lineNum, loc.pos, logLvl.c_str(), what.c_str());
-        fprintf(stdout, "%s\n", sourceCode[loc.lineNum - 1].c_str());
-        fprintf(stdout, "%*s", loc.pos, "^");
+        diagnostics->add(level, what, loc);
+    }
 
-        if (loc.len > 1) {
-            fprintf(stdout, "%s", string(loc.len - 1, '~').c_str());
-        }
+    /**
+     * Sets the buffer to collect the diagnostics of this context into.
+     *
+     * @param out the diagnostics buffer.
+     */
+    void setDiagnostics(Diagnostics* out) {
+        diagnostics = out;
+    }
 
-        fprintf(stdout, "\n");
+    /**
+     * Returns the buffer the diagnostics of this context are collected into.
+     */
+    Diagnostics* getDiagnostics() {
+        return diagnostics;
     }
 
     /**
-     * Returns the symbol table as a string for visualization.
-     *
-     * @return a string representing the symbol table.
+     * Returns the symbols declared in this context, paired with their scope depths, in declaration order.
      */
-    string getSymbolTableStr() {
-        stringstream ss;
+    vector<pair<int, DeclarationNode*>>& getSymbols() {
+        return symbols;
+    }
 
-        ss << "+-------+---------------------------------------------------+---------------------+---------------------+-------+\n";
-        ss << "| scope | type                                              | identifier          | alias               | used  |\n";
-        ss << "+-------+---------------------------------------------------+---------------------+---------------------+-------+\n";
+    /**
+     * Writes the symbol table into the given output sink, one entry per symbol in declaration order.
+     *
+     * @param writer the output sink to write into.
+     */
+    void writeSymbolTable(SymbolTableWriter& writer) {
+        writer.begin(symbols.size());
 
         for (int i = 0; i < symbols.size(); ++i) {
-            int scope = symbols[i].first;
+            if (symbols[i].second == NULL) {
+                writer.write(retiredSymbols[symbols[i].first]);
+            } else {
+                writer.write(getSymbolEntry(symbols[i].first, symbols[i].second));
+            }
+        }
+
+        writer.finish();
+    }
+
+    /**
+     * Retires the local symbols declared since the given index of the symbol table,
+     * so that their declaration nodes can be released once their function is compiled.
+     *
+     * The use counts of the local symbols are final once their function is analyzed,
+     * so their entries of the symbol table are built right away.
+     * The global symbols are not retired, since later statements may still use them.
+     *
+     * @param begin    the index of the first symbol to retire.
+     * @param keepRows whether to keep the entries of the retired symbols in the symbol table or to drop them.
+     */
+    void retireSymbols(size_t begin, bool keepRows) {
+        size_t n = begin;
+
+        for (size_t i = begin; i < symbols.size(); ++i) {
             DeclarationNode* sym = symbols[i].second;
 
-            ss << "| " << left << setw(6) << scope;
-            ss << "| " << left << setw(50) << sym->declaredType();
-            ss << "| " << left << setw(20) << sym->ident->name;
-            ss << "| " << left << setw(20) << sym->alias;
-            ss << "| " << left << setw(6) << sym->used << "|\n";
-            ss << "+-------+---------------------------------------------------+---------------------+---------------------+-------+\n";
+            if (sym == NULL || sym->global) {
+                symbols[n++] = symbols[i];
+            } else if (keepRows) {
+                // A retired symbol refers to its entry instead of its scope depth
+                retiredSymbols.push_back(getSymbolEntry(symbols[i].first, sym));
+                symbols[n++] = { (int) retiredSymbols.size() - 1, NULL };
+            }
         }
 
-        return ss.str();
+        symbols.resize(n);
     }
 
 private:
 
+    ScopeContext() {}
+
     /**
-     * Reads the given source code file and fills
-     * the global vector {@code sourceCode}.
+     * Returns the entry of the given symbol in the symbol table.
+     *
+     * @param scope the scope depth of the symbol.
+     * @param sym   the declaration node of the symbol.
+     *
+     * @return the entry of the symbol.
      */
-    void readSourceCode() {
-        // Open input file
-        ifstream fin(sourceFilename);
-
-        // Check that the file was opened successfully
-        if (!fin.is_open()) {
-            return;
-        }
+    SymbolEntry getSymbolEntry(int scope, DeclarationNode* sym) const {
+        return { scope, sym->ident->loc, sym->declaredType(), sym->ident->name,
+                 interns->str(sym->alias), sym->used };
+    }
 
-        // Read the source code line by line
-        string line;
-        while (getline(fin, line)) {
-            sourceCode.push_back(Utils::replaceTabsWithSpaces(line));
+    /**
+     * Returns the global symbol of the given identifier, if among the given number of first global declarations.
+     *
+     * @param identifier the interned name of the symbol to search for.
+     * @param count      the number of the first global declarations to search in.
+     *
+     * @return a pointer on the found symbol, or {@code NULL} if not available.
+     */
+    DeclarationNode* getGlobalSymbol(InternId identifier, int count) const {
+        if (identifier >= bindings.size() || bindings[identifier].empty()) {
+            return NULL;
         }
 
-        // Close
-        fin.close();
+        const Binding& b = bindings[identifier].front();
+        return (b.depth == 0 && b.order < count) ? b.sym : NULL;
     }
 };
 
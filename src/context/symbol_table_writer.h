@@ -0,0 +1,355 @@
+#ifndef __SYMBOL_TABLE_WRITER_H_
+#define __SYMBOL_TABLE_WRITER_H_
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+#include "../utils/utils.h"
+
+using namespace std;
+
+
+//
+// Binary symbol table definitions
+//
+#define SYM_TABLE_MAGIC     "MPPS"
+#define SYM_TABLE_VERSION   1
+
+/**
+ * The output formats of the symbol table.
+ */
+enum SymbolTableFormat {
+    SYM_TABLE_TEXT,
+    SYM_TABLE_CSV,
+    SYM_TABLE_JSON,
+    SYM_TABLE_BINARY
+};
+
+/**
+ * Struct holding a single entry of the symbol table.
+ */
+struct SymbolEntry {
+    int scope;                      // The scope depth of the symbol, 0 for the global scope
+    Location loc;                   // The location of the identifier of the symbol in its declaration
+    string type;                    // The declared type of the symbol (e.g. "const int", "int(*)(int, char)")
+    string name;                    // The identifier of the symbol
+    string alias;                   // The unique name of the symbol in the quadruples (e.g. "x@2")
+    int used;                       // The number of times the symbol is read
+};
+
+/**
+ * The base class of all output sinks of the symbol table.
+ *
+ * The entries are written one by one in declaration order, straight into the output stream.
+ */
+class SymbolTableWriter {
+public:
+
+    virtual ~SymbolTableWriter() {}
+
+    /**
+     * Starts the symbol table.
+     *
+     * @param count the number of entries to be written.
+     */
+    virtual void begin(size_t count) {}
+
+    /**
+     * Writes the given entry into this sink.
+     *
+     * @param entry the entry to write.
+     */
+    virtual void write(const SymbolEntry& entry) = 0;
+
+    /**
+     * Finalizes the symbol table after all entries have been written.
+     */
+    virtual void finish() {}
+
+    /**
+     * Constructs a new symbol table writer of the given format.
+     *
+     * @param format the output format.
+     * @param out    the output stream to write into, opened in binary mode for the binary format.
+     *
+     * @return the writer, owned by the caller.
+     */
+    static SymbolTableWriter* create(SymbolTableFormat format, ostream& out);
+};
+
+/**
+ * Symbol table text serializer, drawing the table as a box with a row per symbol.
+ *
+ * The columns are padded to fixed widths, which longer values overflow;
+ * tools should read one of the other formats instead.
+ */
+class SymbolTextWriter : public SymbolTableWriter {
+private:
+    ostream& out;
+    string row;                     // The row being formatted, reused across the rows
+
+public:
+
+    /**
+     * Constructs a new text serializer.
+     *
+     * @param out the output stream to write into.
+     */
+    SymbolTextWriter(ostream& out) : out(out) {}
+
+    virtual void begin(size_t count) {
+        out << separator();
+        out << "| scope | type                                              | identifier          | alias               | used  |\n";
+        out << separator();
+    }
+
+    virtual void write(const SymbolEntry& entry) {
+        row.clear();
+        appendCell(to_string(entry.scope), 6);
+        appendCell(entry.type, 50);
+        appendCell(entry.name, 20);
+        appendCell(entry.alias, 20);
+        appendCell(to_string(entry.used), 6);
+        row += "|\n";
+        row += separator();
+
+        out.write(row.data(), row.size());
+    }
+
+    virtual void finish() {
+        out << '\n';
+    }
+
+private:
+
+    /**
+     * Appends a cell holding the given value to the current row, left aligned and padded to the given width.
+     */
+    void appendCell(const string& value, size_t width) {
+        row += "| ";
+        row += value;
+
+        if (value.size() < width) {
+            row.append(width - value.size(), ' ');
+        }
+    }
+
+    /**
+     * Returns the line separating the rows of the table.
+     */
+    static const char* separator() {
+        return "+-------+---------------------------------------------------+---------------------+---------------------+-------+\n";
+    }
+};
+
+/**
+ * Symbol table CSV serializer, following RFC 4180.
+ *
+ * Writes a header line, then a line per symbol with its scope depth, declaration line and column,
+ * type, identifier, alias and use count. The fields holding commas or quotes are quoted.
+ */
+class SymbolCsvWriter : public SymbolTableWriter {
+private:
+    ostream& out;
+    string line;                    // The line being formatted, reused across the lines
+
+public:
+
+    /**
+     * Constructs a new CSV serializer.
+     *
+     * @param out the output stream to write into.
+     */
+    SymbolCsvWriter(ostream& out) : out(out) {}
+
+    virtual void begin(size_t count) {
+        out << "scope,line,column,type,identifier,alias,used\n";
+    }
+
+    virtual void write(const SymbolEntry& entry) {
+        line.clear();
+        line += to_string(entry.scope) + ',';
+        line += to_string(entry.loc.lineNum) + ',';
+        line += to_string(entry.loc.pos) + ',';
+        appendField(entry.type);
+        line += ',';
+        appendField(entry.name);
+        line += ',';
+        appendField(entry.alias);
+        line += ',';
+        line += to_string(entry.used) + '\n';
+
+        out.write(line.data(), line.size());
+    }
+
+private:
+
+    /**
+     * Appends the given field to the current line, quoting it if needed.
+     */
+    void appendField(const string& value) {
+        if (value.find_first_of(",\"\r\n") == string::npos) {
+            line += value;
+            return;
+        }
+
+        line += '"';
+
+        for (char c : value) {
+            line += c;
+
+            if (c == '"') {
+                line += '"';
+            }
+        }
+
+        line += '"';
+    }
+};
+
+/**
+ * Symbol table JSON serializer.
+ *
+ * Writes a single JSON object holding the array of the symbols, one per line.
+ */
+class SymbolJsonWriter : public SymbolTableWriter {
+private:
+    ostream& out;
+    string line;                    // The line being formatted, reused across the lines
+    bool first = true;
+
+public:
+
+    /**
+     * Constructs a new JSON serializer.
+     *
+     * @param out the output stream to write into.
+     */
+    SymbolJsonWriter(ostream& out) : out(out) {}
+
+    virtual void begin(size_t count) {
+        out << "{\"symbols\": [";
+    }
+
+    virtual void write(const SymbolEntry& entry) {
+        line = (first ? "\n  " : ",\n  ");
+        line += "{\"scope\": ";
+        line += to_string(entry.scope);
+        line += ", \"line\": ";
+        line += to_string(entry.loc.lineNum);
+        line += ", \"column\": ";
+        line += to_string(entry.loc.pos);
+        line += ", \"type\": ";
+        appendString(entry.type);
+        line += ", \"identifier\": ";
+        appendString(entry.name);
+        line += ", \"alias\": ";
+        appendString(entry.alias);
+        line += ", \"used\": ";
+        line += to_string(entry.used);
+        line += '}';
+        first = false;
+
+        out.write(line.data(), line.size());
+    }
+
+    virtual void finish() {
+        out << (first ? "]}\n" : "\n]}\n");
+    }
+
+private:
+
+    /**
+     * Appends the given string to the current line as a JSON string literal.
+     */
+    void appendString(const string& value) {
+        line += '"';
+
+        // The identifiers and types rarely need escaping, so they are appended as is when possible
+        if (any_of(value.begin(), value.end(), [](char c) { return c == '"' || c == '\\' || (unsigned char) c < 0x20; })) {
+            line += Utils::escapeJson(value);
+        } else {
+            line += value;
+        }
+
+        line += '"';
+    }
+};
+
+/**
+ * Symbol table binary serializer.
+ *
+ * The table begins with the magic SYM_TABLE_MAGIC, then the version and the number of entries as 32-bit integers.
+ * Each entry is made of its scope depth, declaration line, declaration column and use count as 32-bit integers,
+ * followed by its type, identifier and alias, each as a 32-bit length then its bytes.
+ * All integers are stored in the native byte order, as in the binary quadruples image.
+ */
+class SymbolBinaryWriter : public SymbolTableWriter {
+private:
+    ostream& out;
+    string record;                  // The entry being encoded, reused across the entries
+
+public:
+
+    /**
+     * Constructs a new binary serializer.
+     *
+     * @param out the binary output stream to write into.
+     */
+    SymbolBinaryWriter(ostream& out) : out(out) {}
+
+    virtual void begin(size_t count) {
+        record.assign(SYM_TABLE_MAGIC, 4);
+        appendInt(SYM_TABLE_VERSION);
+        appendInt(count);
+
+        out.write(record.data(), record.size());
+    }
+
+    virtual void write(const SymbolEntry& entry) {
+        record.clear();
+        appendInt(entry.scope);
+        appendInt(entry.loc.lineNum);
+        appendInt(entry.loc.pos);
+        appendInt(entry.used);
+        appendString(entry.type);
+        appendString(entry.name);
+        appendString(entry.alias);
+
+        out.write(record.data(), record.size());
+    }
+
+private:
+
+    /**
+     * Appends the given 32-bit integer to the current record.
+     */
+    void appendInt(uint32_t value) {
+        record.append((const char*) &value, sizeof(value));
+    }
+
+    /**
+     * Appends the given string to the current record, preceded by its length.
+     */
+    void appendString(const string& value) {
+        appendInt(value.size());
+        record += value;
+    }
+};
+
+inline SymbolTableWriter* SymbolTableWriter::create(SymbolTableFormat format, ostream& out) {
+    switch (format) {
+        case SYM_TABLE_CSV:
+            return new SymbolCsvWriter(out);
+        case SYM_TABLE_JSON:
+            return new SymbolJsonWriter(out);
+        case SYM_TABLE_BINARY:
+            return new SymbolBinaryWriter(out);
+        default:
+            return new SymbolTextWriter(out);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -1,10 +1,33 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "context/compile_context.h"
 #include "context/scope_context.h"
 #include "context/generation_context.h"
+#include "quadruples/quad_writer.h"
+#include "quadruples/quad_image.h"
+#include "quadruples/quad_optimizer.h"
 #include "parse_tree/parse_tree.h"
+#include "parse_tree/node_visitor.h"
+#include "utils/arena.h"
+#include "utils/diagnostics.h"
+#include "utils/parallel.h"
+#include "utils/time_report.h"
 #include "utils/utils.h"
 #include "utils/consts.h"
 
@@ -16,26 +39,66 @@ using namespace std;
 #define LANG_NAME           "M++"
 #define VERSION             "1.0"
 #define VERSION_DATE        "May 9, 2019"
+#define OUTPUT_BUFFER_SIZE  (1 << 16)
+#define QUAD_EXTENSION      ".quad"
+#define SYM_TABLE_EXTENSION ".sym"
 
-//
-// External functions & variables
-//
-extern int yyparse();
-extern FILE* yyin;
-extern StatementNode* programRoot;
+/**
+ * Struct holding a single input file of a multi-file build, along with its outputs and results.
+ */
+struct CompileJob {
+    string inputFilename;
+    string outputFilename;
+    string symbolTableFilename;
+    stringstream log;           // The buffered diagnostics of the compilation, if printed as text
+    Diagnostics diagnostics;    // The structured diagnostics of the compilation, if printed as JSON or SARIF
+    stringstream errs;          // The buffered errors and statistics of the compilation
+    double latency = 0;         // The wall time of the compilation in milliseconds
+    TimeReport report = TimeReport(false);  // The costs of the phases of the compilation, measured on its thread
+    bool done = false;
+};
 
 //
 // Global Variables
 //
-string inputFilename;
+vector<string> inputFilenames;
 string outputFilename = "out.o";
 string symbolTableFilename;
 bool warn = false;
+bool emitBinary = false;
+bool showStats = false;
+bool singlePass = false;
+bool streaming = false;
+int optLevel = 0;
+int jobCount = 0;
+int maxParseDepth = PARSER_MAX_DEPTH;
+int errorLimit = 0;
+DiagnosticsFormat diagnosticsFormat = DIAG_TEXT;
+SymbolTableFormat symbolTableFormat = SYM_TABLE_TEXT;
+bool timeReport = false;
+bool timeReportJson = false;
+TimeReport timeReportTotal;
+thread_local size_t heapAllocCount = 0;
+atomic<size_t> sharedHeapAllocCount(0);
 
 //
 // Functions prototypes
 //
-void writeToFile(string data, string filename);
+void compileFile(const string& inputFilename, const string& outputFilename, const string& symbolTableFilename,
+                 int threads, ostream& log, Diagnostics& diagnostics, ostream& errs, TimeReport* report);
+void compileFiles();
+void reportDiagnostics(CompileContext& compilation, ostream& log, Diagnostics& diagnostics);
+void printDiagnostics(const vector<const Diagnostics*>& files);
+void writeToFile(string data, string filename, ostream& errs);
+bool generateToFile(CompileContext& compilation, string filename, int threads, ostream& errs);
+void writeSymbolTable(CompileContext& compilation, const string& filename, ostream& errs);
+bool analyzeWithoutOutput(CompileContext& compilation, int threads, ostream& errs);
+void printParseStats(const CompileContext& compilation, size_t heapAllocs, ostream& errs);
+void printBuildStats(const vector<CompileJob>& jobs, double seconds, int threads);
+void printMemoryStats(ostream& errs);
+string replaceExtension(const string& filename, const string& ext);
+void readResponseFile(const string& filename);
+void checkInputFilenames();
 void printHelp();
 void printVersion();
 void parseArguments(int argc, char* argv[]);
@@ -51,38 +114,179 @@ int main(int argc, char* argv[]) {
     // Parse incoming arguments
     parseArguments(argc, argv);
 
-    // Construct context objects
-    ScopeContext scopeContext(inputFilename, warn);
-    GenerationContext genContext;
+    if (inputFilenames.size() == 1) {
+        int threads = (jobCount > 0 ? jobCount : defaultThreadCount());
+        Diagnostics diagnostics;
+
+        compileFile(inputFilenames[0], outputFilename, symbolTableFilename, threads, cout, diagnostics, cerr,
+                    timeReport ? &timeReportTotal : NULL);
+        printDiagnostics({ &diagnostics });
+    } else {
+        compileFiles();
+    }
 
-    // Open input file for Lex & Yacc
-    yyin = fopen(inputFilename.c_str(), "r");
+    if (showStats) {
+        printMemoryStats(cerr);
+    }
 
-    if (yyin == NULL) {
-        fprintf(stderr, "error: could not open the input file '%s'!\n", inputFilename.c_str());
-        exit(0);
+    if (timeReport) {
+        cerr << (timeReportJson ? timeReportTotal.toJson() : timeReportTotal.toText());
     }
 
-    // Construct the parse tree
-    yyparse();
+    return 0;
+}
+
+/**
+ * Compiles a single source code file.
+ *
+ * @param inputFilename       the filename of the source code to compile.
+ * @param outputFilename      the filename to write the quadruples into.
+ * @param symbolTableFilename the filename to write the symbol table into, or empty to skip it.
+ * @param threads             the number of threads to analyze and generate the functions of the file on.
+ * @param log                 the stream to write the diagnostics into, if printed as text.
+ * @param diagnostics         the buffer to move the diagnostics into, if printed as JSON or SARIF.
+ * @param errs                the stream to write the errors and statistics of the compiler into.
+ * @param report              the report to measure the phases of the compilation into, or {@code NULL}.
+ */
+void compileFile(const string& inputFilename, const string& outputFilename, const string& symbolTableFilename,
+                 int threads, ostream& log, Diagnostics& diagnostics, ostream& errs, TimeReport* report) {
+    // Construct the context of the compilation, owning all of its state
+    CompileContext compilation(inputFilename, warn);
+    compilation.keepSymbols = !symbolTableFilename.empty();
+    compilation.maxParseDepth = maxParseDepth;
+    compilation.timeReport = report;
+
+    bool valid;
+
+    if (streaming) {
+        // Compile each top-level statement as soon as it is parsed
+        valid = generateToFile(compilation, outputFilename, threads, errs);
+    } else {
+        // Construct the parse tree
+        size_t heapAllocs = heapAllocCount;
+
+        if (!compilation.parse()) {
+            errs << "error: could not open the input file '" << inputFilename << "'!\n";
+            reportDiagnostics(compilation, log, diagnostics);
+            return;
+        }
+
+        if (showStats) {
+            printParseStats(compilation, heapAllocCount - heapAllocs, errs);
+        }
+
+        // Apply semantic check and quadruple generation, in a single traversal of the tree if requested
+        valid = (singlePass || compilation.analyze(threads)) && generateToFile(compilation, outputFilename, threads, errs);
+    }
 
-    // Apply semantic check and quadruple generation
-    if (programRoot != NULL && programRoot->analyze(&scopeContext)) {
-        // cout << programRoot->toString() << endl;
-        writeToFile(programRoot->generateQuad(&genContext), outputFilename);
-        writeToFile(scopeContext.getSymbolTableStr(), symbolTableFilename);
+    if (valid) {
+        // cout << compilation.programRoot->toString() << endl;
+        writeSymbolTable(compilation, symbolTableFilename, errs);
     } else {
-        writeToFile("", outputFilename);
+        compilation.enterPhase(PHASE_OUTPUT);
+        writeToFile("", outputFilename, errs);
     }
 
-    // Finalize and release allocated memory
-    fclose(yyin);
+    // Emit the diagnostics collected during the whole compilation at once
+    compilation.enterPhase(PHASE_OUTPUT);
+    reportDiagnostics(compilation, log, diagnostics);
+    compilation.enterPhase(-1);
 
-    if (programRoot != NULL) {
-        delete programRoot;
+    // Finalize and release allocated memory, the whole parse tree at once
+    compilation.release();
+}
+
+/**
+ * Compiles all the input files on a pool of worker threads.
+ *
+ * Each output is written next to its input file. The diagnostics of each file are buffered,
+ * and printed in the order of the input files regardless of the order of completion.
+ */
+void compileFiles() {
+    vector<CompileJob> jobs(inputFilenames.size());
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        jobs[i].inputFilename = inputFilenames[i];
+        jobs[i].outputFilename = replaceExtension(inputFilenames[i], QUAD_EXTENSION);
+
+        if (!symbolTableFilename.empty()) {
+            jobs[i].symbolTableFilename = replaceExtension(inputFilenames[i], SYM_TABLE_EXTENSION);
+        }
     }
 
-    return 0;
+    int threads = min(jobCount > 0 ? jobCount : defaultThreadCount(), (int) jobs.size());
+
+    size_t nextPrint = 0;
+    mutex printLock;
+
+    auto start = chrono::steady_clock::now();
+
+    // The files are already compiled in parallel, so the functions of each file are compiled sequentially
+    parallelFor(jobs.size(), threads, [&](size_t i, int worker) {
+        CompileJob& job = jobs[i];
+
+        auto jobStart = chrono::steady_clock::now();
+        compileFile(job.inputFilename, job.outputFilename, job.symbolTableFilename, 1, job.log, job.diagnostics,
+                    job.errs, timeReport ? &job.report : NULL);
+        job.latency = chrono::duration<double, milli>(chrono::steady_clock::now() - jobStart).count();
+
+        // Print the diagnostics of all the consecutive completed files
+        lock_guard<mutex> guard(printLock);
+        job.done = true;
+
+        for (; nextPrint < jobs.size() && jobs[nextPrint].done; ++nextPrint) {
+            cout << jobs[nextPrint].log.str() << flush;
+            cerr << jobs[nextPrint].errs.str() << flush;
+            jobs[nextPrint].log.str("");
+            jobs[nextPrint].errs.str("");
+        }
+    });
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    vector<const Diagnostics*> diagnostics;
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        timeReportTotal.merge(jobs[i].report);
+        diagnostics.push_back(&jobs[i].diagnostics);
+    }
+
+    printDiagnostics(diagnostics);
+
+    printBuildStats(jobs, seconds, threads);
+}
+
+/**
+ * Cuts off the diagnostics of the given compilation at the error limit, then either writes them
+ * into the given stream at once if printed as text, or moves them into the given buffer otherwise.
+ *
+ * @param compilation the compilation to report the diagnostics of.
+ * @param log         the stream to write the diagnostics into, if printed as text.
+ * @param diagnostics the buffer to move the diagnostics into, if printed as JSON or SARIF.
+ */
+void reportDiagnostics(CompileContext& compilation, ostream& log, Diagnostics& diagnostics) {
+    compilation.diagnostics.limitErrors(errorLimit);
+
+    if (diagnosticsFormat == DIAG_TEXT) {
+        string text = compilation.diagnostics.toText(compilation.source);
+        log.write(text.data(), text.size());
+    } else {
+        compilation.diagnostics.resolveColumns(compilation.source);
+        diagnostics = move(compilation.diagnostics);
+    }
+}
+
+/**
+ * Prints the structured diagnostics of all the compiled files as a single JSON or SARIF document
+ * into the standard output stream. Nothing is printed if the diagnostics are printed as text.
+ *
+ * @param files the diagnostics of each compiled file, in the order of the input files.
+ */
+void printDiagnostics(const vector<const Diagnostics*>& files) {
+    if (diagnosticsFormat == DIAG_JSON) {
+        cout << Diagnostics::toJson(files) << flush;
+    } else if (diagnosticsFormat == DIAG_SARIF) {
+        cout << Diagnostics::toSarif(files, LANG_NAME, VERSION) << flush;
+    }
 }
 
 /**
@@ -90,8 +294,9 @@ int main(int argc, char* argv[]) {
  *
  * @param data     the data to write.
  * @param filename the filename of the file to write into.
+ * @param errs     the stream to write the errors into.
  */
-void writeToFile(string data, string filename) {
+void writeToFile(string data, string filename, ostream& errs) {
     if (filename.empty()) {
         return;
     }
@@ -99,7 +304,7 @@ void writeToFile(string data, string filename) {
     ofstream fout(filename);
 
     if (!fout.is_open()) {
-        fprintf(stderr, "error: could not write in file '%s'!\n", filename.c_str());
+        errs << "error: could not write in file '" << filename << "'!\n";
         return;
     }
 
@@ -108,18 +313,311 @@ void writeToFile(string data, string filename) {
     fout.close();
 }
 
+/**
+ * Creates a new file and streams the quadruples of the given compilation into it.
+ *
+ * In streaming mode, the source file is parsed and analyzed while generating it.
+ * In single-pass mode, the parse tree is analyzed while generating it.
+ * Otherwise, it must be already analyzed.
+ *
+ * @param compilation the compilation holding the parse tree.
+ * @param filename    the filename of the file to write into.
+ * @param threads     the number of threads to generate the functions on.
+ * @param errs        the stream to write the errors and statistics into.
+ *
+ * @return {@code false} if the program is found to be semantically invalid; {@code true} otherwise.
+ */
+bool generateToFile(CompileContext& compilation, string filename, int threads, ostream& errs) {
+    if (filename.empty()) {
+        return analyzeWithoutOutput(compilation, threads, errs);
+    }
+
+    compilation.enterPhase(PHASE_OUTPUT);
+
+    // The output buffer is owned by this compilation, so concurrent compilations never share it
+    vector<char> buffer(OUTPUT_BUFFER_SIZE);
+
+    ofstream fout;
+    fout.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    fout.open(filename, emitBinary ? ios::out | ios::binary : ios::out);
+
+    if (!fout.is_open()) {
+        errs << "error: could not write in file '" << filename << "'!\n";
+        return analyzeWithoutOutput(compilation, threads, errs);
+    }
+
+    QuadWriter* writer;
+
+    if (emitBinary) {
+        writer = new QuadBinaryWriter(fout);
+    } else {
+        writer = new QuadTextWriter(fout);
+    }
+
+    // The procedures are written while being generated, so the writer is charged to the output phase on its own
+    PhaseWriter output(&compilation, writer);
+    QuadOptimizer optimizer(&output, optLevel);
+    bool valid = true;
+
+    if (streaming) {
+        if (!compilation.parse(&optimizer)) {
+            errs << "error: could not open the input file '" << compilation.sourceFilename << "'!\n";
+            valid = false;
+        } else {
+            valid = compilation.isStreamValid();
+        }
+    } else if (singlePass) {
+        valid = compilation.compile(&optimizer);
+    } else {
+        compilation.generate(&optimizer, threads);
+    }
+
+    compilation.enterPhase(PHASE_GENERATE);
+    optimizer.finish();
+
+    compilation.enterPhase(PHASE_OUTPUT);
+
+    if (!emitBinary) {
+        fout << endl;
+    }
+
+    if (showStats) {
+        optimizer.printStats(errs);
+    }
+
+    delete writer;
+    fout.close();
+    return valid;
+}
+
+/**
+ * Writes the symbol table of the given compilation into the given file, in the requested format.
+ * The entries are streamed straight into the file rather than rendered into memory first.
+ *
+ * @param compilation the analyzed compilation.
+ * @param filename    the filename of the file to write into, or empty to skip the symbol table.
+ * @param errs        the stream to write the errors into.
+ */
+void writeSymbolTable(CompileContext& compilation, const string& filename, ostream& errs) {
+    if (filename.empty()) {
+        return;
+    }
+
+    compilation.enterPhase(PHASE_SYMBOLS);
+
+    vector<char> buffer(OUTPUT_BUFFER_SIZE);
+
+    ofstream fout;
+    fout.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    fout.open(filename, symbolTableFormat == SYM_TABLE_BINARY ? ios::out | ios::binary : ios::out);
+
+    if (!fout.is_open()) {
+        errs << "error: could not write in file '" << filename << "'!\n";
+        return;
+    }
+
+    SymbolTableWriter* writer = SymbolTableWriter::create(symbolTableFormat, fout);
+    compilation.scopeContext.writeSymbolTable(*writer);
+    delete writer;
+
+    compilation.enterPhase(PHASE_OUTPUT);
+    fout.close();
+}
+
+/**
+ * Applies the semantic checks on the given compilation when its quadruples cannot be written,
+ * in the modes analyzing the program while generating it.
+ *
+ * @param compilation the compilation, parsed unless in streaming mode.
+ * @param threads     the number of threads to analyze the functions on.
+ * @param errs        the stream to write the errors into.
+ *
+ * @return {@code false} if the program is found to be semantically invalid; {@code true} otherwise.
+ */
+bool analyzeWithoutOutput(CompileContext& compilation, int threads, ostream& errs) {
+    if (!streaming && !singlePass) {
+        return true;
+    }
+
+    if (streaming && !compilation.parse()) {
+        errs << "error: could not open the input file '" << compilation.sourceFilename << "'!\n";
+        return false;
+    }
+
+    return compilation.analyze(threads);
+}
+
+/**
+ * Prints the allocation statistics of the parsing phase into the given stream.
+ *
+ * @param compilation the compilation holding the parse tree.
+ * @param heapAllocs  the number of heap allocations made during parsing.
+ * @param errs        the stream to print into.
+ */
+void printParseStats(const CompileContext& compilation, size_t heapAllocs, ostream& errs) {
+    const Arena& arena = compilation.arena;
+    int lines = max(compilation.curLoc.lineNum, 1);
+    char line[256];
+
+    snprintf(line, sizeof(line), "parser: %d source lines, %zu arena allocations (%zu bytes in %zu blocks)\n",
+             lines, arena.getAllocCount(), arena.getUsedBytes(), arena.getBlockCount());
+    errs << line;
+    snprintf(line, sizeof(line), "parser: %zu heap allocations (%.2f per source line)\n",
+             heapAllocs, (double) heapAllocs / lines);
+    errs << line;
+
+    NodeCounter counter;
+    counter.count(compilation.programRoot);
+    snprintf(line, sizeof(line), "parser: %zu parse tree nodes (%.2f per source line)\n",
+             counter.total, (double) counter.total / lines);
+    errs << line;
+}
+
+/**
+ * Prints the peak memory usage of the compiler process into the given stream.
+ *
+ * @param errs the stream to print into.
+ */
+void printMemoryStats(ostream& errs) {
+#ifndef _WIN32
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        errs << "memory: " << usage.ru_maxrss << " KB peak resident set size\n";
+    }
+#endif
+}
+
+/**
+ * Prints the throughput and the per-file latency percentiles of a multi-file build
+ * into the standard error stream.
+ *
+ * @param jobs    the compiled files.
+ * @param seconds the total wall time of the build in seconds.
+ * @param threads the number of worker threads used.
+ */
+void printBuildStats(const vector<CompileJob>& jobs, double seconds, int threads) {
+    vector<double> latencies;
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        latencies.push_back(jobs[i].latency);
+    }
+
+    sort(latencies.begin(), latencies.end());
+
+    // Nearest-rank percentile of the sorted latencies
+    auto percentile = [&](double p) {
+        size_t rank = (size_t) (p / 100 * latencies.size() + 0.999999);
+        return latencies[min(max(rank, (size_t) 1), latencies.size()) - 1];
+    };
+
+    fprintf(stderr, "build: %zu files in %.3f s on %d threads (%.1f files/sec)\n",
+            jobs.size(), seconds, threads, jobs.size() / max(seconds, 1e-9));
+    fprintf(stderr, "build: latency p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+            percentile(50), percentile(90), percentile(99), latencies.back());
+}
+
+/**
+ * Replaces the extension of the given filename, keeping its directory.
+ *
+ * @param filename the filename to replace its extension.
+ * @param ext      the new extension, including the leading dot.
+ *
+ * @return the filename with the new extension.
+ */
+string replaceExtension(const string& filename, const string& ext) {
+    size_t dot = filename.find_last_of('.');
+    size_t sep = filename.find_last_of("/\\");
+
+    if (dot == string::npos || (sep != string::npos && dot < sep)) {
+        return filename + ext;
+    }
+
+    return filename.substr(0, dot) + ext;
+}
+
+/**
+ * Reads the input filenames listed in the given response file, one filename per line.
+ *
+ * @param filename the filename of the response file.
+ */
+void readResponseFile(const string& filename) {
+    ifstream fin(filename);
+
+    if (!fin.is_open()) {
+        fprintf(stderr, "error: could not open the response file '%s'!\n", filename.c_str());
+        exit(0);
+    }
+
+    string line;
+
+    while (getline(fin, line)) {
+        size_t l = line.find_first_not_of(" \t\r");
+        size_t r = line.find_last_not_of(" \t\r");
+
+        if (l != string::npos) {
+            inputFilenames.push_back(line.substr(l, r - l + 1));
+        }
+    }
+}
+
+/**
+ * Checks that the input files of a multi-file build are written into distinct output files,
+ * since each output is written next to its input file by a concurrent compilation.
+ * The repeated input files are dropped, while the distinct input files sharing an output file
+ * (e.g. {@code a.mpp} and {@code a.cpp}, both written into {@code a.quad}) terminate the program.
+ */
+void checkInputFilenames() {
+    unordered_map<string, string> outputs;     // The input filename of each output filename
+    vector<string> unique;
+
+    for (const string& input : inputFilenames) {
+        string output = replaceExtension(input, QUAD_EXTENSION);
+        auto it = outputs.find(output);
+
+        if (it == outputs.end()) {
+            outputs[output] = input;
+            unique.push_back(input);
+        } else if (it->second == input) {
+            fprintf(stderr, "warning: ignoring the repeated input file '%s'\n", input.c_str());
+        } else {
+            fprintf(stderr, "error: the input files '%s' and '%s' are both written into '%s'!\n",
+                    it->second.c_str(), input.c_str(), output.c_str());
+            exit(1);
+        }
+    }
+
+    inputFilenames.swap(unique);
+}
+
 /**
  * Prints the help menu of the compiler into the
  * standard output stream, then terminates the program.
  */
 void printHelp() {
     printf("%s version %s, %s\n\n", LANG_NAME, VERSION, VERSION_DATE);
-    printf("Usage: %s [switches] <input_file>\n", LANG_NAME);
+    printf("Usage: %s [switches] <input_file>...\n", LANG_NAME);
     printf("    -h, --help                   Print the help menu and exit.\n");
-    printf("    -o, --output <filename>      Specify the output filename.\n");
+    printf("    @<filename>                  Read the input filenames from the given file, one per line.\n");
+    printf("    --diagnostics=<format>       Specify the format of the diagnostics (text, json or sarif).\n");
+    printf("    --emit=<text|binary>         Specify the format of the output quadruples.\n");
+    printf("    --error-limit=<count>        Stop reporting the diagnostics of a file after the given number of errors.\n");
+    printf("    -j<count>                    Specify the number of compilation threads (default: the core count).\n");
+    printf("    --max-parse-depth=<depth>    Specify the maximum nesting depth of the parser (default: %d).\n", PARSER_MAX_DEPTH);
+    printf("    -O<level>                    Specify the optimization level (0 or 1).\n");
+    printf("    -o, --output <filename>      Specify the output filename (single input file only).\n");
     printf("    -s, --sym_table <filename>   Output the symbol table to the given file\n");
+    printf("    --sym_table-format=<format>  Specify the format of the symbol table (text, csv, json or binary).\n");
+    printf("    --single-pass                Analyze and generate each top-level statement in a single traversal.\n");
+    printf("    --stats                      Print the compilation statistics.\n");
+    printf("    --stream                     Compile and release each top-level statement as soon as it is parsed.\n");
+    printf("    --time-report[=<text|json>]  Print the time, memory and allocations of each compilation phase.\n");
     printf("    -v, --version                Print the installed version number and exit.\n");
     printf("    -w, --warn                   Show warning messages.\n");
+    printf("\n");
+    printf("With multiple input files, the outputs of each file are written next to it (e.g. a.mpp into a.quad\n");
+    printf("and a.sym), and the filenames given to -o and -s are ignored. Distinct input files written into\n");
+    printf("the same output (e.g. a.mpp and a.cpp) are rejected.\n");
     exit(0);
 }
 
@@ -139,6 +637,8 @@ void printVersion() {
  * @param argv the arguments them self as sent to the program.
  */
 void parseArguments(int argc, char* argv[]) {
+    bool outputGiven = false;
+
     // Iterate over all sent arguments
     while (++argv, --argc) {
         // Commands begin with dash "-"
@@ -163,6 +663,98 @@ void parseArguments(int argc, char* argv[]) {
                 }
 
                 outputFilename = string(*(++argv));
+                outputGiven = true;
+            }
+            // Set optimization level
+            else if (strcmp(*argv, "-O0") == 0 || strcmp(*argv, "-O1") == 0) {
+                optLevel = (*argv)[2] - '0';
+            }
+            // Set the number of compilation threads
+            else if (strncmp(*argv, "-j", 2) == 0) {
+                jobCount = atoi(*argv + 2);
+
+                if (jobCount < 1) {
+                    fprintf(stderr, "error: invalid number of threads '%s'!\n\n", *argv + 2);
+                    printHelp();
+                }
+            }
+            // Set the maximum nesting depth of the parser
+            else if (strncmp(*argv, "--max-parse-depth=", 18) == 0) {
+                maxParseDepth = atoi(*argv + 18);
+
+                if (maxParseDepth < 1) {
+                    fprintf(stderr, "error: invalid parser depth '%s'!\n\n", *argv + 18);
+                    printHelp();
+                }
+            }
+            // Set the maximum number of errors reported per file
+            else if (strncmp(*argv, "--error-limit=", 14) == 0) {
+                errorLimit = atoi(*argv + 14);
+
+                if (errorLimit < 0) {
+                    fprintf(stderr, "error: invalid error limit '%s'!\n\n", *argv + 14);
+                    printHelp();
+                }
+            }
+            // Set the format of the diagnostics
+            else if (strncmp(*argv, "--diagnostics=", 14) == 0) {
+                if (strcmp(*argv + 14, "text") == 0) {
+                    diagnosticsFormat = DIAG_TEXT;
+                } else if (strcmp(*argv + 14, "json") == 0) {
+                    diagnosticsFormat = DIAG_JSON;
+                } else if (strcmp(*argv + 14, "sarif") == 0) {
+                    diagnosticsFormat = DIAG_SARIF;
+                } else {
+                    fprintf(stderr, "error: unknown diagnostics format '%s'!\n\n", *argv + 14);
+                    printHelp();
+                }
+            }
+            // Show compilation statistics
+            else if (strcmp(*argv, "--stats") == 0) {
+                showStats = true;
+            }
+            // Analyze and generate in a single traversal
+            else if (strcmp(*argv, "--single-pass") == 0) {
+                singlePass = true;
+            }
+            // Compile each top-level statement while parsing
+            else if (strcmp(*argv, "--stream") == 0) {
+                streaming = true;
+            }
+            // Report the costs of each compilation phase
+            else if (strcmp(*argv, "--time-report") == 0 || strcmp(*argv, "--time-report=text") == 0) {
+                timeReport = true;
+                timeReportJson = false;
+            }
+            else if (strcmp(*argv, "--time-report=json") == 0) {
+                timeReport = true;
+                timeReportJson = true;
+            }
+            // Set output format
+            else if (strncmp(*argv, "--emit=", 7) == 0) {
+                if (strcmp(*argv + 7, "binary") == 0) {
+                    emitBinary = true;
+                } else if (strcmp(*argv + 7, "text") == 0) {
+                    emitBinary = false;
+                } else {
+                    fprintf(stderr, "error: unknown output format '%s'!\n\n", *argv + 7);
+                    printHelp();
+                }
+            }
+            // Set symbol table output format
+            else if (strncmp(*argv, "--sym_table-format=", 19) == 0) {
+                if (strcmp(*argv + 19, "text") == 0) {
+                    symbolTableFormat = SYM_TABLE_TEXT;
+                } else if (strcmp(*argv + 19, "csv") == 0) {
+                    symbolTableFormat = SYM_TABLE_CSV;
+                } else if (strcmp(*argv + 19, "json") == 0) {
+                    symbolTableFormat = SYM_TABLE_JSON;
+                } else if (strcmp(*argv + 19, "binary") == 0) {
+                    symbolTableFormat = SYM_TABLE_BINARY;
+                } else {
+                    fprintf(stderr, "error: unknown symbol table format '%s'!\n\n", *argv + 19);
+                    printHelp();
+                }
             }
             // Set symbol table output filename
             else if (strcmp(*argv, "-s") == 0 || strcmp(*argv, "--sym_table") == 0) {
@@ -178,19 +770,52 @@ void parseArguments(int argc, char* argv[]) {
                 fprintf(stderr, "unknown argument '%s'\n", *argv);
             }
         }
-        // Set input filename
-        else if (inputFilename.empty()) {
-            inputFilename = string(*argv);
+        // Read input filenames from a response file
+        else if (**argv == '@') {
+            readResponseFile(string(*argv + 1));
         }
-        // Other arguments
+        // Add input filename
         else {
-            fprintf(stderr, "warning: too many arguments, '%s' ignored\n", *argv);
+            inputFilenames.push_back(string(*argv));
         }
     }
 
     // Check if input filename is specified
-    if (inputFilename.empty()) {
+    if (inputFilenames.empty()) {
         fprintf(stderr, "error: missing input filename argument!\n\n");
         printHelp();
     }
+
+    checkInputFilenames();
+
+    // Each output of a multi-file build is written next to its input file
+    if (outputGiven && inputFilenames.size() > 1) {
+        fprintf(stderr, "warning: ignoring the output filename '%s' with multiple input files, "
+                        "the quadruples of each file are written next to it\n", outputFilename.c_str());
+    }
 }
+
+
+// =====================================================================================================
+// Heap Allocations Counting
+// =========================
+
+void* operator new(size_t size) {
+    heapAllocCount++;
+
+    if (timeReport) {
+        sharedHeapAllocCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    void* ptr = malloc(size > 0 ? size : 1);
+
+    if (ptr == NULL) {
+        throw bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
\ No newline at end of file
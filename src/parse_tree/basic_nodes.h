@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <atomic>
 
 #include "../utils/consts.h"
 #include "../utils/utils.h"
@@ -32,8 +33,12 @@ typedef vector<ExpressionNode*> ExprList;
 
 /**
  * The base class of all nodes in the parse tree.
+ *
+ * Nodes are allocated in the arena of the compilation and don't own their children,
+ * the whole tree is released at once with the arena, so nodes must never be deleted.
  */
 struct Node {
+    NodeKind kind;          // The kind of the node, set by the constructor of its concrete class
     Location loc;
 
     Node() {}
@@ -48,23 +53,39 @@ struct Node {
         return true;
     }
 
-    virtual string generateQuad(GenerationContext* context) {
-        return "";
-    }
+    virtual void generateQuad(GenerationContext* context) {}
 
     virtual string toString() {
         return "";
     }
 };
 
+/**
+ * Casts the given node into the given concrete node class by checking its kind,
+ * as a cheaper replacement of {@code dynamic_cast}.
+ *
+ * @param node the node to cast, or {@code NULL}.
+ *
+ * @return the node as the given class if it is of its kind; {@code NULL} otherwise.
+ */
+template<typename T>
+inline T* nodeCast(Node* node) {
+    return (node != NULL && node->kind == T::KIND) ? static_cast<T*>(node) : NULL;
+}
+
 /**
  * The base class of all statement nodes in the parse tree.
  */
 struct StatementNode : public Node {
+    static const NodeKind KIND = NODE_STATEMENT;
 
-    StatementNode() {}
+    StatementNode() {
+        this->kind = KIND;
+    }
 
-    StatementNode(const Location& loc) : Node(loc) {}
+    StatementNode(const Location& loc) : Node(loc) {
+        this->kind = KIND;
+    }
 
     virtual string toString(int ind = 0) {
         return string(ind, ' ') + ";" ;
@@ -81,9 +102,10 @@ struct DeclarationNode : public StatementNode {
     //
     // NOTE: the following variables will be computed after calling analyze function
     //
-    string alias;                       // Alias name to avoid same identifier in different scopes
-    int used = 0;                       // The number of times this declaration node has been read
+    InternId alias = -1;                // Interned alias name to avoid same identifier in different scopes
+    atomic<int> used{0};                // The number of times this declaration node has been read, from any thread
     bool initialized = false;           // Whether this declaration node has been initialized or not
+    bool global = false;                // Whether this declaration node is declared in the global scope or not
 
     DeclarationNode(const Location& loc) : StatementNode(loc) {}
 
@@ -103,14 +125,20 @@ struct ExpressionNode : public StatementNode {
     DeclarationNode* reference = NULL;  // Reference variable of the expression is exist
     bool constant = false;              // Whether the expression is of constant value or not
     bool used = false;                  // Whether the value of the expression is to be used or not
+    bool folded = false;                // Whether the value of the expression is evaluated at compile time or not
+    Value constValue;                   // The evaluated value of the expression if folded, of the expression's type
 
     ExpressionNode() {}
 
     ExpressionNode(const Location& loc) : StatementNode(loc) {}
 
-    virtual int getConstIntValue() {
-        return -1;
-    }
+    /**
+     * Evaluates the value of this expression at compile time if all of its operands are known,
+     * and stores it in {@code constValue}.
+     *
+     * @param context the scope context to report evaluation problems into.
+     */
+    virtual void fold(ScopeContext* context) {}
     
     virtual bool analyze(ScopeContext* context) {
         return analyze(context, false);
@@ -121,6 +149,17 @@ struct ExpressionNode : public StatementNode {
         return true;
     }
 
+    /**
+     * Generates the quadruples of this expression as a branch condition,
+     * jumping into the given label if the condition evaluates to the given truth value,
+     * and falling through into the next instruction otherwise.
+     *
+     * @param context the generation context.
+     * @param label   the label to jump into.
+     * @param jumpIf  the truth value of the condition to jump on.
+     */
+    virtual void generateBranch(GenerationContext* context, int label, bool jumpIf);
+
     virtual string exprTypeStr() {
         return reference ? reference->declaredType() : Utils::dtypeToStr(type);
     }
@@ -130,9 +169,12 @@ struct ExpressionNode : public StatementNode {
  * The node class holding a data type in the parse tree.
  */
 struct TypeNode : public Node {
+    static const NodeKind KIND = NODE_TYPE;
+
     DataType type;
 
     TypeNode(const Location& loc, DataType type) : Node(loc) {
+        this->kind = KIND;
         this->type = type;
     }
 
@@ -145,9 +187,12 @@ struct TypeNode : public Node {
  * The node class representing a syntax error statement.
  */
 struct ErrorNode : public StatementNode {
+    static const NodeKind KIND = NODE_ERROR;
+
     string what;
 
     ErrorNode(const Location& loc, const string& what) : StatementNode(loc) {
+        this->kind = KIND;
         this->what = what;
         this->loc.pos -= this->loc.len - 1;
     }
@@ -62,8 +62,12 @@ bool CaseLabelNode::analyze(ScopeContext* context) {
             context->log("case quantity not an integer", expr->loc, LOG_ERROR);
             ret = false;
         }
-        if (ret && expr->constant && Utils::isIntegerType(expr->type)) {
-            int val = expr->getConstIntValue();
+        if (ret && !expr->folded) {
+            context->log("case label does not reduce to an integer constant", expr->loc, LOG_ERROR);
+            ret = false;
+        }
+        if (ret) {
+            int val = Utils::convertValue(expr->constValue, expr->type, DTYPE_INT).intVal;
 
             if (switchStmt->caseMap.count(val)) {
                 context->log("duplicate case value", loc, LOG_ERROR);
@@ -1,140 +1,187 @@
+#include <algorithm>
+
 #include "../parse_tree.h"
 #include "../../context/generation_context.h"
 
+#define SWITCH_MIN_CASES        4           // The minimum number of cases to lower a switch into a jump table
+#define SWITCH_MIN_DENSITY      0.4         // The minimum ratio of cases to jump table entries
+#define SWITCH_MAX_TABLE_SIZE   (1 << 16)   // The maximum number of jump table entries
+#define SWITCH_LEAF_CASES       3           // The maximum number of cases compared linearly in a binary search
+
 
-string IfNode::generateQuad(GenerationContext* context) {
-    string ret;
+void IfNode::generateQuad(GenerationContext* context) {
     int label1 = context->labelCounter++;
 
-    ret += cond->generateQuad(context);
-    ret += Utils::oprToQuad(OPR_JZ, cond->type) + " L" + to_string(label1) + "\n";
-    ret += ifBody->generateQuad(context);
+    cond->generateBranch(context, label1, false);
+    ifBody->generateQuad(context);
 
     if (elseBody) {
         int label2 = context->labelCounter++;
 
-        ret += Utils::oprToQuad(OPR_JMP) + " L" + to_string(label2) + "\n";
-        ret += "L" + to_string(label1) + ":\n";
-        ret += elseBody->generateQuad(context);
-        ret += "L" + to_string(label2) + ":\n";
+        context->emitJump(loc, OPR_JMP, label2);
+        context->emitLabel(loc, label1);
+        elseBody->generateQuad(context);
+        context->emitLabel(loc, label2);
     }
     else {
-        ret += "L" + to_string(label1) + ":\n";
+        context->emitLabel(loc, label1);
+    }
+}
+
+/**
+ * Emits the dispatch code of a switch statement as a binary search over its sorted case values,
+ * falling back to a linear chain of comparisons at the leaves of the search.
+ *
+ * @param context      the generation context.
+ * @param loc          the location of the switch statement.
+ * @param condAlias    the interned alias of the temporary holding the switch condition.
+ * @param cases        the sorted case values paired with their body labels.
+ * @param lo           the index of the first case to dispatch.
+ * @param hi           the index of the last case to dispatch.
+ * @param defaultLabel the label to jump to if no case matches.
+ */
+static void emitCaseSearch(GenerationContext* context, const Location& loc, InternId condAlias,
+                           const vector<pair<int, int>>& cases, int lo, int hi, int defaultLabel) {
+    if (hi - lo + 1 <= SWITCH_LEAF_CASES) {
+        for (int i = lo; i <= hi; ++i) {
+            context->emitSymbol(loc, OPR_PUSH, DTYPE_INT, condAlias);
+            context->emitValue(loc, DTYPE_INT, Utils::intToValue(cases[i].first, DTYPE_INT));
+            context->emitOpr(loc, OPR_EQUAL, DTYPE_INT);
+            context->emitJump(loc, OPR_JNZ, cases[i].second, DTYPE_BOOL);
+        }
+
+        context->emitJump(loc, OPR_JMP, defaultLabel);
+        return;
     }
 
-    return ret;
+    int mid = (lo + hi + 1) / 2;
+    int rightLabel = context->labelCounter++;
+
+    context->emitSymbol(loc, OPR_PUSH, DTYPE_INT, condAlias);
+    context->emitValue(loc, DTYPE_INT, Utils::intToValue(cases[mid].first, DTYPE_INT));
+    context->emitOpr(loc, OPR_GREATER_EQUAL, DTYPE_INT);
+    context->emitJump(loc, OPR_JNZ, rightLabel, DTYPE_BOOL);
+
+    emitCaseSearch(context, loc, condAlias, cases, lo, mid - 1, defaultLabel);
+    context->emitLabel(loc, rightLabel);
+    emitCaseSearch(context, loc, condAlias, cases, mid, hi, defaultLabel);
 }
 
-string SwitchNode::generateQuad(GenerationContext* context) {
-    string ret;
-    vector<pair<int, int>> labelPairs;
-    int defaultLabel = -1;
+void SwitchNode::generateQuad(GenerationContext* context) {
+    vector<int> bodyLabels;
+    map<ExpressionNode*, int> exprLabels;
+    vector<pair<int, int>> cases;
     int breakLabel = context->labelCounter++;
-
-    ret += cond->generateQuad(context);
-    ret += Utils::oprToQuad(OPR_POP, cond->type) + " SWITCH_COND@" + to_string(breakLabel) + "\n";
-    context->breakLabels.push(breakLabel);
+    int defaultLabel = breakLabel;
+    InternId condAlias = context->interns->intern("SWITCH_COND@" + to_string(breakLabel));
 
     for (int i = 0; i < caseLabels.size(); i++) {
-        int label1 = context->labelCounter++;
+        bodyLabels.push_back(context->labelCounter++);
+
         if (caseLabels[i] == NULL) {
-            defaultLabel = label1;
-            labelPairs.push_back({-1, label1});
+            defaultLabel = bodyLabels[i];
         }
         else {
-            int label2 = context->labelCounter++;
-            labelPairs.push_back({label1, label2});
+            exprLabels[caseLabels[i]] = bodyLabels[i];
         }
     }
 
-    for (int i = 0; i < caseLabels.size(); i++) {
-        if (caseLabels[i]) {
-            if (i > 0) {
-                ret += Utils::oprToQuad(OPR_JMP) + " L" + to_string(labelPairs[i].second) + "\n";
-            }
+    for (auto& it : caseMap) {
+        cases.push_back({it.first, exprLabels[it.second->expr]});
+    }
 
-            DataType resultType = max(cond->type, caseLabels[i]->type);
+    sort(cases.begin(), cases.end());
 
-            ret += "L" + to_string(labelPairs[i].first) + ":\n";
-            ret += Utils::oprToQuad(OPR_PUSH, cond->type) + " SWITCH_COND@" + to_string(context->breakLabels.top()) + "\n";
-            ret += Utils::dtypeConvQuad(cond->type, resultType);
-            ret += Utils::oprToQuad(OPR_PUSH, caseLabels[i]->type) + " " + to_string(caseLabels[i]->getConstIntValue()) + "\n";
-            ret += Utils::dtypeConvQuad(caseLabels[i]->type, resultType);
-            ret += Utils::oprToQuad(OPR_EQUAL, resultType) + "\n";
-            ret += Utils::oprToQuad(OPR_JZ, DTYPE_BOOL) + " L";
+    // The case values are compared as integers, so the condition is converted once
+    cond->generateQuad(context);
+    context->emitConv(loc, cond->type, DTYPE_INT);
+    context->emitSymbol(loc, OPR_POP, DTYPE_INT, condAlias);
 
-            if (i == caseLabels.size() - 1) {               // my case label is last
-                ret += (hasDefaultLabel ? to_string(defaultLabel) : to_string(breakLabel)) + "\n";
-            }
-            else if (labelPairs[i + 1].first == -1) {       // my next label is default
-                ret += ((i + 1 == caseLabels.size() - 1) ? to_string(defaultLabel) : to_string(labelPairs[i + 2].first)) + "\n";
+    int n = cases.size();
+    long long range = (n > 0 ? (long long) cases.back().first - cases.front().first + 1 : 0);
+
+    if (n >= SWITCH_MIN_CASES && range <= SWITCH_MAX_TABLE_SIZE && n >= range * SWITCH_MIN_DENSITY) {
+        // Dense cases: index a jump table by the offset of the condition from the smallest case value,
+        // out of range offsets (including negative ones, compared as unsigned) jump to the default label
+        int minVal = cases.front().first;
+
+        context->emitSymbol(loc, OPR_PUSH, DTYPE_INT, condAlias);
+
+        if (minVal != 0) {
+            context->emitValue(loc, DTYPE_INT, Utils::intToValue(minVal, DTYPE_INT));
+            context->emitOpr(loc, OPR_SUB, DTYPE_INT);
+        }
+
+        context->emitJump(loc, OPR_JTAB, defaultLabel);
+
+        for (int i = 0, j = 0; i < range; ++i) {
+            if (cases[j].first == minVal + i) {
+                context->emitJump(loc, OPR_CASE, cases[j++].second);
             }
-            else {                                          // my next is case
-                ret += to_string(labelPairs[i + 1].first) + "\n";
+            else {
+                context->emitJump(loc, OPR_CASE, defaultLabel);
             }
         }
+    }
+    else {
+        // Sparse or few cases: binary search over the sorted case values
+        emitCaseSearch(context, loc, condAlias, cases, 0, n - 1, defaultLabel);
+    }
+
+    context->breakLabels.push(breakLabel);
 
-        ret += "L" + to_string(labelPairs[i].second) + ":\n";
+    for (int i = 0; i < caseLabels.size(); i++) {
+        context->emitLabel(loc, bodyLabels[i]);
 
         for (int j = 0;j < caseStmts[i].size();j++) {
-            ret += caseStmts[i][j]->generateQuad(context);
+            caseStmts[i][j]->generateQuad(context);
         }
     }
 
     context->breakLabels.pop();
-    ret += "L" + to_string(breakLabel) + ":\n";
-
-    return ret;
+    context->emitLabel(loc, breakLabel);
 }
 
-string WhileNode::generateQuad(GenerationContext* context) {
-    string ret;
+void WhileNode::generateQuad(GenerationContext* context) {
     int label1 = context->labelCounter++;
     int label2 = context->labelCounter++;
 
-    ret += "L" + to_string(label1) + ":\n";
-    ret += cond->generateQuad(context);
-    ret += Utils::oprToQuad(OPR_JZ, cond->type) + " L" + to_string(label2) + "\n";
+    context->emitLabel(loc, label1);
+    cond->generateBranch(context, label2, false);
 
     context->breakLabels.push(label2);
     context->continueLabels.push(label1);
 
-    ret += body->generateQuad(context);
+    body->generateQuad(context);
 
     context->breakLabels.pop();
     context->continueLabels.pop();
 
-    ret += Utils::oprToQuad(OPR_JMP) + " L" + to_string(label1) + "\n";
-    ret += "L" + to_string(label2) + ":\n";
-
-    return ret;
+    context->emitJump(loc, OPR_JMP, label1);
+    context->emitLabel(loc, label2);
 }
 
-string DoWhileNode::generateQuad(GenerationContext* context) {
-    string ret;
+void DoWhileNode::generateQuad(GenerationContext* context) {
     int label1 = context->labelCounter++;
     int label2 = context->labelCounter++;
     int label3 = context->labelCounter++;
 
-    ret += "L" + to_string(label1) + ":\n";
+    context->emitLabel(loc, label1);
 
     context->breakLabels.push(label3);
     context->continueLabels.push(label2);
 
-    ret += body->generateQuad(context);
+    body->generateQuad(context);
 
     context->continueLabels.pop();
     context->breakLabels.pop();
 
-    ret += "L" + to_string(label2) + ":\n";
-    ret += cond->generateQuad(context);
-    ret += Utils::oprToQuad(OPR_JNZ, cond->type) + " L" + to_string(label1) + "\n";
-    ret += "L" + to_string(label3) + ":\n";
-
-    return ret;
+    context->emitLabel(loc, label2);
+    cond->generateBranch(context, label1, true);
+    context->emitLabel(loc, label3);
 }
 
-string ForNode::generateQuad(GenerationContext* context) {
+void ForNode::generateQuad(GenerationContext* context) {
     /**
      * InitStmt Code
      * L1: Cond Code
@@ -148,46 +195,42 @@ string ForNode::generateQuad(GenerationContext* context) {
      *
      **/
 
-    string ret;
     int label1 = context->labelCounter++;
     int label2 = context->labelCounter++;
     int label3 = context->labelCounter++;
 
     if (initStmt) {
-        ret += initStmt->generateQuad(context);
+        initStmt->generateQuad(context);
     }
 
-    ret += "L" + to_string(label1) + ":\n";
+    context->emitLabel(loc, label1);
 
     if (cond) {
-        ret += cond->generateQuad(context);
-        ret += Utils::oprToQuad(OPR_JZ, cond->type) + " L" + to_string(label3) + "\n";
+        cond->generateBranch(context, label3, false);
     }
 
     context->breakLabels.push(label3);
     context->continueLabels.push(label2);
 
-    ret += body->generateQuad(context);
+    body->generateQuad(context);
 
     context->continueLabels.pop();
     context->breakLabels.pop();
 
-    ret += "L" + to_string(label2) + ":\n";
+    context->emitLabel(loc, label2);
 
     if (inc) {
-        ret += inc->generateQuad(context);
+        inc->generateQuad(context);
     }
 
-    ret += Utils::oprToQuad(OPR_JMP) + " L" + to_string(label1) + "\n";
-    ret += "L" + to_string(label3) + ":\n";
-
-    return ret;
+    context->emitJump(loc, OPR_JMP, label1);
+    context->emitLabel(loc, label3);
 }
 
-string BreakStmtNode::generateQuad(GenerationContext* context) {
-    return Utils::oprToQuad(OPR_JMP) + " L" + to_string(context->breakLabels.top()) + "\n";
+void BreakStmtNode::generateQuad(GenerationContext* context) {
+    context->emitJump(loc, OPR_JMP, context->breakLabels.top());
 }
 
-string ContinueStmtNode::generateQuad(GenerationContext* context) {
-    return Utils::oprToQuad(OPR_JMP) + " L" + to_string(context->continueLabels.top()) + "\n";
+void ContinueStmtNode::generateQuad(GenerationContext* context) {
+    context->emitJump(loc, OPR_JMP, context->continueLabels.top());
 }
\ No newline at end of file
@@ -10,34 +10,31 @@
  * The node class holding an if statement in the parse tree.
  */
 struct IfNode : public StatementNode {
+    static const NodeKind KIND = NODE_IF;
+
     ExpressionNode* cond;
     StatementNode* ifBody;
     StatementNode* elseBody;
 
     IfNode(const Location& loc, ExpressionNode* cond, StatementNode* ifBody, StatementNode* elseBody = NULL)
             : StatementNode(loc) {
+        this->kind = KIND;
         this->cond = cond;
         this->ifBody = ifBody;
         this->elseBody = elseBody;
     }
 
-    virtual ~IfNode() {
-        if (cond) delete cond;
-        if (ifBody) delete ifBody;
-        if (elseBody) delete elseBody;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "if (" + cond->toString() + ")\n";
-        ret += ifBody->toString(ind + (dynamic_cast<BlockNode*>(ifBody) ? 0 : 4));
+        ret += ifBody->toString(ind + (nodeCast<BlockNode>(ifBody) ? 0 : 4));
 
         if (elseBody) {
             ret += "\n" + string(ind, ' ') + "else\n";
-            ret += elseBody->toString(ind + (dynamic_cast<BlockNode*>(elseBody) ? 0 : 4));
+            ret += elseBody->toString(ind + (nodeCast<BlockNode>(elseBody) ? 0 : 4));
         }
 
         return ret;
@@ -48,19 +45,17 @@ struct IfNode : public StatementNode {
  * The node class holding a case label in the parse tree.
  */
 struct CaseLabelNode : public StatementNode {
+    static const NodeKind KIND = NODE_CASE_LABEL;
+
     ExpressionNode* expr;
     StatementNode* stmt;
 
     CaseLabelNode(const Location& loc, ExpressionNode* expr, StatementNode* stmt) : StatementNode(loc) {
+        this->kind = KIND;
         this->expr = expr;
         this->stmt = stmt;
     }
 
-    virtual ~CaseLabelNode() {
-        if (expr) delete expr;
-        if (stmt) delete stmt;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
     virtual string toString(int ind = 0) {
@@ -74,6 +69,8 @@ struct CaseLabelNode : public StatementNode {
  * The node class holding a switch statement in the parse tree.
  */
 struct SwitchNode : public StatementNode {
+    static const NodeKind KIND = NODE_SWITCH;
+
     ExpressionNode* cond;
     StatementNode* body;
 
@@ -88,17 +85,13 @@ struct SwitchNode : public StatementNode {
 
 
     SwitchNode(const Location& loc, ExpressionNode* cond, StatementNode* body) : StatementNode(loc) {
+        this->kind = KIND;
         this->cond = cond;
         this->body = body;
     }
 
-    virtual ~SwitchNode() {
-        if (cond) delete cond;
-        if (body) delete body;
-    }
-
     virtual void populate() {
-        BlockNode* block = dynamic_cast<BlockNode*>(body);
+        BlockNode* block = nodeCast<BlockNode>(body);
 
         if (block == NULL) {
             addCaseBlock(body);
@@ -113,7 +106,7 @@ struct SwitchNode : public StatementNode {
     virtual void addCaseBlock(StatementNode* stmt) {
         CaseLabelNode* caseLabel;
 
-        while (caseLabel = dynamic_cast<CaseLabelNode*>(stmt)) {
+        while (caseLabel = nodeCast<CaseLabelNode>(stmt)) {
             caseLabels.push_back(caseLabel->expr);
             caseStmts.push_back(StmtList());
 
@@ -127,11 +120,11 @@ struct SwitchNode : public StatementNode {
 
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "switch (" + cond->toString() + ")\n";
-        ret += body->toString(ind + (dynamic_cast<BlockNode*>(body) ? 0 : 4));
+        ret += body->toString(ind + (nodeCast<BlockNode>(body) ? 0 : 4));
 
         //
         // Switch case block population debugging code
@@ -162,26 +155,24 @@ struct SwitchNode : public StatementNode {
  * The node class holding a while loop in the parse tree.
  */
 struct WhileNode : public StatementNode {
+    static const NodeKind KIND = NODE_WHILE;
+
     ExpressionNode* cond;
     StatementNode* body;
 
     WhileNode(const Location& loc, ExpressionNode* cond, StatementNode* body) : StatementNode(loc) {
+        this->kind = KIND;
         this->cond = cond;
         this->body = body;
     }
 
-    virtual ~WhileNode() {
-        if (cond) delete cond;
-        if (body) delete body;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "while (" + cond->toString() + ") \n";
-        ret += body->toString(ind + (dynamic_cast<BlockNode*>(body) ? 0 : 4));
+        ret += body->toString(ind + (nodeCast<BlockNode>(body) ? 0 : 4));
         return ret;
     }
 };
@@ -190,26 +181,24 @@ struct WhileNode : public StatementNode {
  * The node class holding a do-while loop in the parse tree.
  */
 struct DoWhileNode : public StatementNode {
+    static const NodeKind KIND = NODE_DO_WHILE;
+
     ExpressionNode* cond;
     StatementNode* body;
 
     DoWhileNode(const Location& loc, ExpressionNode* cond, StatementNode* body) : StatementNode(loc) {
+        this->kind = KIND;
         this->cond = cond;
         this->body = body;
     }
 
-    virtual ~DoWhileNode() {
-        if (cond) delete cond;
-        if (body) delete body;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "do\n";
-        ret += body->toString(ind + (dynamic_cast<BlockNode*>(body) ? 0 : 4)) + "\n";
+        ret += body->toString(ind + (nodeCast<BlockNode>(body) ? 0 : 4)) + "\n";
         ret += string(ind, ' ') + "while (" + cond->toString() + ");";
         return ret;
     }
@@ -219,6 +208,8 @@ struct DoWhileNode : public StatementNode {
  * The node class holding a for loop in the parse tree.
  */
 struct ForNode : public StatementNode {
+    static const NodeKind KIND = NODE_FOR;
+
     StatementNode* initStmt;
     ExpressionNode* cond;
     ExpressionNode* inc;
@@ -226,29 +217,23 @@ struct ForNode : public StatementNode {
 
     ForNode(const Location& loc, StatementNode* initStmt, ExpressionNode* cond, ExpressionNode* inc,
             StatementNode* body) : StatementNode(loc) {
+        this->kind = KIND;
         this->initStmt = initStmt;
         this->cond = cond;
         this->inc = inc;
         this->body = body;
     }
 
-    virtual ~ForNode() {
-        if (initStmt) delete initStmt;
-        if (cond) delete cond;
-        if (inc) delete inc;
-        if (body) delete body;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "for (";
         ret += (initStmt ? initStmt->toString() : "") + ";";
         ret += (cond ? cond->toString() : "") + ";";
         ret += (inc ? inc->toString() : "") + ")\n";
-        ret += body->toString(ind + (dynamic_cast<BlockNode*>(body) ? 0 : 4));
+        ret += body->toString(ind + (nodeCast<BlockNode>(body) ? 0 : 4));
         return ret;
     }
 };
@@ -257,12 +242,15 @@ struct ForNode : public StatementNode {
  * The node class holding a break statement in the parse tree.
  */
 struct BreakStmtNode : public StatementNode {
+    static const NodeKind KIND = NODE_BREAK;
 
-    BreakStmtNode(const Location& loc) : StatementNode(loc) {}
+    BreakStmtNode(const Location& loc) : StatementNode(loc) {
+        this->kind = KIND;
+    }
 
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         return string(ind, ' ') + "break";
@@ -273,12 +261,15 @@ struct BreakStmtNode : public StatementNode {
  * The node class holding a continue statement in the parse tree.
  */
 struct ContinueStmtNode : public StatementNode {
+    static const NodeKind KIND = NODE_CONTINUE;
 
-    ContinueStmtNode(const Location& loc) : StatementNode(loc) {}
+    ContinueStmtNode(const Location& loc) : StatementNode(loc) {
+        this->kind = KIND;
+    }
 
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         return string(ind, ' ') + "continue";
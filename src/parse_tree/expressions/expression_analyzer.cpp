@@ -1,26 +1,162 @@
+#include <vector>
+
 #include "../parse_tree.h"
 #include "../../context/scope_context.h"
 
 
+/**
+ * A pending expression on the work stack of {@code analyzeExpression}.
+ */
+struct AnalysisFrame {
+    ExpressionNode* node;   // The expression to analyze
+    bool valueUsed;         // Whether the value of the expression is used or not
+    int next;               // The index of the next operand to analyze, or -1 if the expression is rejected
+    bool valid;             // Whether the operands analyzed so far are semantically valid or not
+};
+
+/**
+ * Returns the operand of the given operator expression at the given index, in the order of analysis.
+ *
+ * @param node      the operator expression.
+ * @param valueUsed whether the value of the expression is used or not.
+ * @param i         the index of the operand.
+ * @param used      set to whether the value of the operand is used or not.
+ *
+ * @return the operand, or {@code NULL} if the expression has no more operands.
+ */
+static ExpressionNode* getOperand(ExpressionNode* node, bool valueUsed, int i, bool& used) {
+    switch (node->kind) {
+        case NODE_EXPR_CONTAINER:
+            used = valueUsed;
+            return i == 0 ? ((ExprContainerNode*) node)->expr : NULL;
+        case NODE_ASSIGN_OPR:
+            used = (i == 0);
+            return i == 0 ? ((AssignOprNode*) node)->rhs : i == 1 ? ((AssignOprNode*) node)->lhs : NULL;
+        case NODE_BINARY_OPR: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+            // The left operand of a logical operator decides whether the right one is evaluated, so it is always used
+            used = valueUsed || (i == 0 && (binary->opr == OPR_LOGICAL_AND || binary->opr == OPR_LOGICAL_OR));
+            return i == 0 ? binary->lhs : i == 1 ? binary->rhs : NULL;
+        }
+        case NODE_UNARY_OPR: {
+            UnaryOprNode* unary = (UnaryOprNode*) node;
+            used = valueUsed || Utils::isLvalueOpr(unary->opr);
+            return i == 0 ? unary->expr : NULL;
+        }
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Checks whether the given node is an operator expression, analyzed through the work stack
+ * of {@code analyzeExpression} rather than by its own {@code analyze} function.
+ */
+static bool isOperator(ExpressionNode* node) {
+    return node->kind == NODE_EXPR_CONTAINER || node->kind == NODE_ASSIGN_OPR ||
+           node->kind == NODE_BINARY_OPR || node->kind == NODE_UNARY_OPR;
+}
+
+/**
+ * Analyzes the given operator expression and all the nested operators below it,
+ * visiting the operands before their operator using a heap-allocated work stack instead of recursion,
+ * so that deeply nested expressions (e.g. a chain of a million additions) cannot overflow the call stack.
+ *
+ * Operands that are not operators (e.g. identifiers and function calls) are analyzed by their own function.
+ *
+ * @param root      the operator expression to analyze.
+ * @param context   the scope context.
+ * @param valueUsed whether the value of the expression is used or not.
+ *
+ * @return {@code true} if the expression is semantically valid; {@code false} otherwise.
+ */
+static bool analyzeExpression(ExpressionNode* root, ScopeContext* context, bool valueUsed) {
+    vector<AnalysisFrame> stack;
+    stack.push_back({root, valueUsed, 0, true});
+
+    while (true) {
+        AnalysisFrame& frame = stack.back();
+        bool ret;
+
+        if (frame.next == 0 && frame.node->kind == NODE_EXPR_CONTAINER) {
+            if (!((ExprContainerNode*) frame.node)->checkScope(context)) {
+                frame.next = -1;
+            }
+        }
+
+        if (frame.next >= 0) {
+            bool used;
+            ExpressionNode* operand = getOperand(frame.node, frame.valueUsed, frame.next, used);
+
+            if (operand != NULL) {
+                frame.next++;
+
+                if (isOperator(operand)) {
+                    stack.push_back({operand, used, 0, true});
+                } else {
+                    // Note that all the operands are analyzed even if one of them is invalid
+                    frame.valid &= operand->analyze(context, used);
+                }
+                continue;
+            }
+        }
+
+        // All the operands are analyzed, so analyze the operator itself
+        switch (frame.node->kind) {
+            case NODE_EXPR_CONTAINER:
+                ret = frame.next >= 0 && ((ExprContainerNode*) frame.node)->analyzeOperator(context, frame.valueUsed, frame.valid);
+                break;
+            case NODE_ASSIGN_OPR:
+                ret = ((AssignOprNode*) frame.node)->analyzeOperator(context, frame.valueUsed, frame.valid);
+                break;
+            case NODE_BINARY_OPR:
+                ret = ((BinaryOprNode*) frame.node)->analyzeOperator(context, frame.valueUsed, frame.valid);
+                break;
+            default:
+                ret = ((UnaryOprNode*) frame.node)->analyzeOperator(context, frame.valueUsed, frame.valid);
+                break;
+        }
+
+        stack.pop_back();
+
+        if (stack.empty()) {
+            return ret;
+        }
+
+        stack.back().valid &= ret;
+    }
+}
+
 bool ExprContainerNode::analyze(ScopeContext* context, bool valueUsed) {
+    return analyzeExpression(this, context, valueUsed);
+}
+
+bool ExprContainerNode::checkScope(ScopeContext* context) {
     if (!context->initializeVar && context->isGlobalScope()) {
         context->log("expression is not allowed in global scope", loc, LOG_ERROR);
         return false;
     }
 
-    bool ret = expr->analyze(context, valueUsed);
+    return true;
+}
 
+bool ExprContainerNode::analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid) {
     type = expr->type;
     reference = expr->reference;
     constant = expr->constant;
     used = valueUsed;
+    folded = expr->folded;
+    constValue = expr->constValue;
 
-    return ret;
+    return operandsValid;
 }
 
 bool AssignOprNode::analyze(ScopeContext* context, bool valueUsed) {
-    if (!(rhs->analyze(context, true) & lhs->analyze(context, false))) {
-        // Note that I used a bitwise AND to execute both lhs and rhs expressions
+    return analyzeExpression(this, context, valueUsed);
+}
+
+bool AssignOprNode::analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid) {
+    if (!operandsValid) {
         return false;
     }
 
@@ -46,14 +182,17 @@ bool AssignOprNode::analyze(ScopeContext* context, bool valueUsed) {
     constant = lhs->constant;
     used = valueUsed;
 
-    reference->initialized = true;
+    context->markInitialized(reference);
 
     return true;
 }
 
 bool BinaryOprNode::analyze(ScopeContext* context, bool valueUsed) {
-    if (!(lhs->analyze(context, valueUsed) & rhs->analyze(context, valueUsed))) {
-        // Note that I used a bitwise AND to execute both lhs and rhs expressions
+    return analyzeExpression(this, context, valueUsed);
+}
+
+bool BinaryOprNode::analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid) {
+    if (!operandsValid) {
         return false;
     }
 
@@ -74,11 +213,17 @@ bool BinaryOprNode::analyze(ScopeContext* context, bool valueUsed) {
     constant = (lhs->constant && rhs->constant);
     used = valueUsed;
 
+    fold(context);
+
     return true;
 }
 
 bool UnaryOprNode::analyze(ScopeContext* context, bool valueUsed) {
-    if (!expr->analyze(context, valueUsed || Utils::isLvalueOpr(opr))) {
+    return analyzeExpression(this, context, valueUsed);
+}
+
+bool UnaryOprNode::analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid) {
+    if (!operandsValid) {
         return false;
     }
 
@@ -105,11 +250,13 @@ bool UnaryOprNode::analyze(ScopeContext* context, bool valueUsed) {
     constant = expr->constant;
     used = valueUsed;
 
+    fold(context);
+
     return true;
 }
 
 bool IdentifierNode::analyze(ScopeContext* context, bool valueUsed) {
-    DeclarationNode* ptr = context->getSymbol(name);
+    DeclarationNode* ptr = context->getSymbol(id);
 
     if (ptr == NULL) {
         context->log("'" + name + "' was not declared in this scope", loc, LOG_ERROR);
@@ -118,7 +265,7 @@ bool IdentifierNode::analyze(ScopeContext* context, bool valueUsed) {
 
     reference = ptr;
 
-    if (dynamic_cast<FunctionNode*>(ptr)) {
+    if (nodeCast<FunctionNode>(ptr)) {
         type = DTYPE_FUNC_PTR;
     } else {
         type = ptr->type->type;
@@ -131,10 +278,11 @@ bool IdentifierNode::analyze(ScopeContext* context, bool valueUsed) {
         reference->used++;
     }
 
-    if (used && !reference->initialized) {
-        context->log("variable or field '" + name + "' used without being initialized", loc, LOG_ERROR);
+    if (used && !context->checkInitialized(reference, loc)) {
         return false;
     }
 
+    fold(context);
+
     return true;
 }
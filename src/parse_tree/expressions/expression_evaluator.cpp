@@ -1,89 +1,204 @@
+#include <climits>
+
 #include "../parse_tree.h"
 #include "../../context/scope_context.h"
 
 
-int BinaryOprNode::getConstIntValue() {
-    int l = lhs->getConstIntValue();
-    int r = rhs->getConstIntValue();
+void BinaryOprNode::fold(ScopeContext* context) {
+    if (!lhs->folded || !rhs->folded) {
+        return;
+    }
+
+    // Evaluate in the promoted type of the operands, exactly like the generated code
+    DataType t = max(lhs->type, rhs->type);
+    Value l = Utils::convertValue(lhs->constValue, lhs->type, t);
+    Value r = Utils::convertValue(rhs->constValue, rhs->type, t);
+
+    if (t == DTYPE_FLOAT) {
+        float a = l.floatVal;
+        float b = r.floatVal;
+
+        switch (opr) {
+            case OPR_ADD:
+                constValue.floatVal = a + b;
+                break;
+            case OPR_SUB:
+                constValue.floatVal = a - b;
+                break;
+            case OPR_MUL:
+                constValue.floatVal = a * b;
+                break;
+            case OPR_DIV:
+                if (b == 0) {
+                    context->log("division by zero", loc, LOG_WARNING);
+                    return;
+                }
+                constValue.floatVal = a / b;
+                break;
+            case OPR_LOGICAL_AND:
+                constValue = Utils::intToValue(a != 0 && b != 0, type);
+                break;
+            case OPR_LOGICAL_OR:
+                constValue = Utils::intToValue(a != 0 || b != 0, type);
+                break;
+            case OPR_GREATER:
+                constValue = Utils::intToValue(a > b, type);
+                break;
+            case OPR_GREATER_EQUAL:
+                constValue = Utils::intToValue(a >= b, type);
+                break;
+            case OPR_LESS:
+                constValue = Utils::intToValue(a < b, type);
+                break;
+            case OPR_LESS_EQUAL:
+                constValue = Utils::intToValue(a <= b, type);
+                break;
+            case OPR_EQUAL:
+                constValue = Utils::intToValue(a == b, type);
+                break;
+            case OPR_NOT_EQUAL:
+                constValue = Utils::intToValue(a != b, type);
+                break;
+            default:
+                return;
+        }
+
+        folded = true;
+        return;
+    }
+
+    // Integer types (bool, char, int) are evaluated as integers then truncated into the expression's type.
+    // Note that unsigned arithmetic is used to wrap around on overflow like the target machine.
+    int a = Utils::convertValue(l, t, DTYPE_INT).intVal;
+    int b = Utils::convertValue(r, t, DTYPE_INT).intVal;
+    int v;
 
     switch (opr) {
         case OPR_ADD:
-            return l + r;
+            v = (int) ((unsigned) a + (unsigned) b);
+            break;
         case OPR_SUB:
-            return l - r;
+            v = (int) ((unsigned) a - (unsigned) b);
+            break;
         case OPR_MUL:
-            return l * r;
+            v = (int) ((unsigned) a * (unsigned) b);
+            break;
         case OPR_DIV:
-            return l / r;
         case OPR_MOD:
-            return l % r;
+            if (b == 0) {
+                context->log("division by zero", loc, LOG_WARNING);
+                return;
+            }
+            if (a == INT_MIN && b == -1) {
+                context->log("integer overflow in expression", loc, LOG_WARNING);
+                return;
+            }
+            v = (opr == OPR_DIV ? a / b : a % b);
+            break;
         case OPR_AND:
-            return l & r;
+            v = a & b;
+            break;
         case OPR_OR:
-            return l | r;
+            v = a | b;
+            break;
         case OPR_XOR:
-            return l ^ r;
+            v = a ^ b;
+            break;
         case OPR_SHL:
-            return l << r;
         case OPR_SHR:
-            return l >> r;
+            if (b < 0) {
+                context->log(string(opr == OPR_SHL ? "left" : "right") + " shift count is negative", loc, LOG_WARNING);
+                return;
+            }
+            if (b >= 32) {
+                context->log(string(opr == OPR_SHL ? "left" : "right") + " shift count >= width of type", loc, LOG_WARNING);
+                return;
+            }
+            v = (opr == OPR_SHL ? (int) ((unsigned) a << b) : a >> b);
+            break;
         case OPR_LOGICAL_AND:
-            return l && r;
+            v = (a != 0 && b != 0);
+            break;
         case OPR_LOGICAL_OR:
-            return l || r;
+            v = (a != 0 || b != 0);
+            break;
         case OPR_GREATER:
-            return l > r;
+            v = (a > b);
+            break;
         case OPR_GREATER_EQUAL:
-            return l >= r;
+            v = (a >= b);
+            break;
         case OPR_LESS:
-            return l < r;
+            v = (a < b);
+            break;
         case OPR_LESS_EQUAL:
-            return l <= r;
+            v = (a <= b);
+            break;
         case OPR_EQUAL:
-            return l == r;
+            v = (a == b);
+            break;
         case OPR_NOT_EQUAL:
-            return l != r;
+            v = (a != b);
+            break;
+        default:
+            return;
     }
 
-    return -1;
+    constValue = Utils::intToValue(v, type);
+    folded = true;
 }
 
-int UnaryOprNode::getConstIntValue() {
-    int v = expr->getConstIntValue();
+void UnaryOprNode::fold(ScopeContext* context) {
+    if (!expr->folded) {
+        return;
+    }
+
+    Value v = Utils::convertValue(expr->constValue, expr->type, type);
+
+    if (type == DTYPE_FLOAT) {
+        switch (opr) {
+            case OPR_U_PLUS:
+                constValue = v;
+                break;
+            case OPR_U_MINUS:
+                constValue.floatVal = -v.floatVal;
+                break;
+            default:
+                return;
+        }
+
+        folded = true;
+        return;
+    }
+
+    int x = Utils::convertValue(v, type, DTYPE_INT).intVal;
 
     switch (opr) {
         case OPR_U_PLUS:
-            return v;
+            break;
         case OPR_U_MINUS:
-            return -v;
+            x = (int) (0u - (unsigned) x);
+            break;
         case OPR_NOT:
-            return ~v;
+            // Bitwise not of a boolean is executed as a logical not
+            x = (type == DTYPE_BOOL ? !x : ~x);
+            break;
         case OPR_LOGICAL_NOT:
-            return !v;
+            x = !x;
+            break;
+        default:
+            return;
     }
 
-    return -1;
+    constValue = Utils::intToValue(x, type);
+    folded = true;
 }
 
-int IdentifierNode::getConstIntValue() {
-    VarDeclarationNode* var = dynamic_cast<VarDeclarationNode*>(reference);
-
-    if (Utils::isIntegerType(type) && var != NULL && var->initialized) {
-        return var->value->getConstIntValue();
-    }
-
-    return -1;
-}
+void IdentifierNode::fold(ScopeContext* context) {
+    VarDeclarationNode* var = nodeCast<VarDeclarationNode>(reference);
 
-int ValueNode::getConstIntValue() {
-    switch (type) {
-        case DTYPE_BOOL:
-            return value == "true";
-        case DTYPE_CHAR:
-            return value[1];
-        case DTYPE_INT:
-            return atoi(value.c_str());
+    if (constant && var != NULL && var->value != NULL && var->value->folded) {
+        constValue = Utils::convertValue(var->value->constValue, var->value->type, type);
+        folded = true;
     }
-
-    return -1;
-}
+}
\ No newline at end of file
@@ -1,100 +1,415 @@
+#include <vector>
+
 #include "../parse_tree.h"
 #include "../../context/generation_context.h"
 
 
-string ExprContainerNode::generateQuad(GenerationContext* context) {
-    return expr->generateQuad(context);
-}
+void ExpressionNode::generateBranch(GenerationContext* context, int label, bool jumpIf) {
+    if (folded) {
+        // The direction of the branch is known at compile time
+        if (Utils::convertValue(constValue, type, DTYPE_BOOL).boolVal == jumpIf) {
+            context->emitJump(loc, OPR_JMP, label);
+        }
+        return;
+    }
 
-string AssignOprNode::generateQuad(GenerationContext* context) {
-    string ret;
+    generateQuad(context);
+    context->emitJump(loc, jumpIf ? OPR_JNZ : OPR_JZ, label, type);
+}
 
-    ret += lhs->generateQuad(context);
-    ret += rhs->generateQuad(context);
-    ret += Utils::dtypeConvQuad(rhs->type, type);
-    ret += Utils::oprToQuad(OPR_POP, type) + " " + lhs->reference->alias + "\n";
+/**
+ * A pending expression on the work stack of {@code generateExpression}.
+ */
+struct GenerationFrame {
+    ExpressionNode* node;   // The expression to generate
+    bool branch;            // Whether to generate the expression as a branch condition or as a value
+    int label;              // The label to jump into, if a branch condition
+    bool jumpIf;            // The truth value of the condition to jump on, if a branch condition
+    int step;               // The step of the generation to resume from
+    int label1;             // The labels allocated by the expression for its own use, or -1 if none
+    int label2;
+};
 
-    if (used) {
-        ret += Utils::oprToQuad(OPR_PUSH, type) + " " + lhs->reference->alias + "\n";
-    }
+/**
+ * The steps at which the generation of an expression is resumed after generating one of its operands.
+ */
+enum GenerationStep {
+    STEP_START,
+    STEP_DONE,
+    STEP_ASSIGN_RHS,            // Generate the right operand of an assignment
+    STEP_ASSIGN_STORE,          // Store the value of an assignment
+    STEP_BINARY_RHS,            // Convert the left operand of a binary operator and generate the right one
+    STEP_BINARY_OPR,            // Convert the right operand of a binary operator and apply the operator
+    STEP_LOGICAL_VALUE,         // Push the truth value of a logical operator, after branching on it
+    STEP_LOGICAL_RHS,           // Generate the right operand of a logical operator whose value is unused
+    STEP_LOGICAL_END,           // Emit the label skipping the right operand of a logical operator
+    STEP_UNARY_OPR,             // Apply a unary operator
+    STEP_BRANCH_JUMP,           // Jump on the truth value of an expression, after generating it
+    STEP_COMPARE_RHS,           // Convert the left operand of a comparison and generate the right one
+    STEP_COMPARE_JUMP,          // Convert the right operand of a comparison, then compare and jump
+    STEP_SHORT_RHS,             // Branch on the right operand of a logical operator
+    STEP_SHORT_END              // Emit the label skipping the right operand of a logical operator
+};
 
-    return ret;
+/**
+ * Checks whether the given node is an operator expression, generated through the work stack
+ * of {@code generateExpression} rather than by its own generation functions.
+ */
+static bool isOperator(ExpressionNode* node) {
+    return node->kind == NODE_EXPR_CONTAINER || node->kind == NODE_ASSIGN_OPR ||
+           node->kind == NODE_BINARY_OPR || node->kind == NODE_UNARY_OPR;
 }
 
-string BinaryOprNode::generateQuad(GenerationContext* context) {
-    string ret;
-    
-    DataType t = max(lhs->type, rhs->type);
+/**
+ * Generates the next part of the quadruples of the given expression, up to its next operand.
+ *
+ * This is the body of the recursive generation functions of the operator expressions,
+ * cut at each operand into steps, so that it can be resumed from the work stack.
+ *
+ * @param context the generation context.
+ * @param frame   the expression to generate, whose step is advanced.
+ * @param operand set to the operand to generate next, with the step to start it from.
+ *
+ * @return {@code true} if an operand is to be generated before resuming the expression;
+ *         {@code false} if the expression is completely generated.
+ */
+static bool generateStep(GenerationContext* context, GenerationFrame& frame, GenerationFrame& operand) {
+    ExpressionNode* node = frame.node;
+    const Location& loc = node->loc;
 
-    if (used) {
-        ret += lhs->generateQuad(context);
-        ret += Utils::dtypeConvQuad(lhs->type, t);
+    // Requests the generation of the given operand, as a value or as a branch condition
+    auto request = [&](ExpressionNode* expr, int next, bool branch = false, int label = 0, bool jumpIf = false) {
+        frame.step = next;
+        operand = {expr, branch, label, jumpIf, STEP_START, -1, -1};
+        return true;
+    };
 
-        ret += rhs->generateQuad(context);
-        ret += Utils::dtypeConvQuad(rhs->type, t);
+    switch (frame.step) {
+        case STEP_DONE:
+            return false;
 
-        ret += Utils::oprToQuad(opr, t) + "\n";
-    }
-    else {
-        ret += lhs->generateQuad(context);
-        ret += rhs->generateQuad(context);
+        case STEP_START:
+            break;
+
+        case STEP_ASSIGN_RHS:
+            return request(((AssignOprNode*) node)->rhs, STEP_ASSIGN_STORE);
+
+        case STEP_ASSIGN_STORE: {
+            AssignOprNode* assign = (AssignOprNode*) node;
+
+            context->emitConv(loc, assign->rhs->type, assign->type);
+            context->emitSymbol(loc, OPR_POP, assign->type, assign->lhs->reference);
+
+            if (assign->used) {
+                context->emitSymbol(loc, OPR_PUSH, assign->type, assign->lhs->reference);
+            }
+
+            // An assignment generated as a branch condition jumps on its value
+            if (frame.branch) {
+                frame.step = STEP_BRANCH_JUMP;
+                return generateStep(context, frame, operand);
+            }
+            return false;
+        }
+
+        case STEP_BINARY_RHS: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+
+            if (binary->used) {
+                context->emitConv(loc, binary->lhs->type, max(binary->lhs->type, binary->rhs->type));
+            }
+            return request(binary->rhs, STEP_BINARY_OPR);
+        }
+
+        case STEP_BINARY_OPR: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+            DataType t = max(binary->lhs->type, binary->rhs->type);
+
+            if (binary->used) {
+                context->emitConv(loc, binary->rhs->type, t);
+                context->emitOpr(loc, binary->opr, t);
+            }
+
+            if (frame.branch) {
+                frame.step = STEP_BRANCH_JUMP;
+                return generateStep(context, frame, operand);
+            }
+            return false;
+        }
+
+        case STEP_LOGICAL_VALUE:
+            context->emitValue(loc, node->type, Utils::intToValue(1, node->type));
+            context->emitJump(loc, OPR_JMP, frame.label2);
+            context->emitLabel(loc, frame.label1);
+            context->emitValue(loc, node->type, Utils::intToValue(0, node->type));
+            context->emitLabel(loc, frame.label2);
+
+            if (frame.branch) {
+                frame.step = STEP_BRANCH_JUMP;
+                return generateStep(context, frame, operand);
+            }
+            return false;
+
+        case STEP_LOGICAL_RHS:
+            return request(((BinaryOprNode*) node)->rhs, STEP_LOGICAL_END);
+
+        case STEP_LOGICAL_END:
+            context->emitLabel(loc, frame.label1);
+
+            if (frame.branch) {
+                frame.step = STEP_BRANCH_JUMP;
+                return generateStep(context, frame, operand);
+            }
+            return false;
+
+        case STEP_UNARY_OPR: {
+            UnaryOprNode* unary = (UnaryOprNode*) node;
+            DataType type = unary->type;
+
+            if (unary->used) {
+                context->emitConv(loc, unary->expr->type, type);
+            }
+
+            switch (unary->opr) {
+                case OPR_PRE_INC:
+                case OPR_PRE_DEC:
+                    context->emitOpr(loc, unary->opr, type);
+                    context->emitSymbol(loc, OPR_POP, type, unary->expr->reference);
+
+                    if (unary->used) {
+                        context->emitSymbol(loc, OPR_PUSH, type, unary->expr->reference);
+                    }
+                    break;
+                case OPR_SUF_INC:
+                case OPR_SUF_DEC:
+                    if (unary->used) {
+                        context->emitSymbol(loc, OPR_PUSH, type, unary->expr->reference);
+                    }
+
+                    context->emitOpr(loc, unary->opr, type);
+                    context->emitSymbol(loc, OPR_POP, type, unary->expr->reference);
+                    break;
+                case OPR_U_MINUS:
+                case OPR_NOT:
+                case OPR_LOGICAL_NOT:
+                    if (unary->used) {
+                        context->emitOpr(loc, unary->opr, type);
+                    }
+                    break;
+            }
+
+            if (frame.branch) {
+                frame.step = STEP_BRANCH_JUMP;
+                return generateStep(context, frame, operand);
+            }
+            return false;
+        }
+
+        case STEP_BRANCH_JUMP:
+            context->emitJump(loc, frame.jumpIf ? OPR_JNZ : OPR_JZ, frame.label, node->type);
+            return false;
+
+        case STEP_COMPARE_RHS: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+
+            context->emitConv(loc, binary->lhs->type, max(binary->lhs->type, binary->rhs->type));
+            return request(binary->rhs, STEP_COMPARE_JUMP);
+        }
+
+        case STEP_COMPARE_JUMP: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+            DataType t = max(binary->lhs->type, binary->rhs->type);
+
+            context->emitConv(loc, binary->rhs->type, t);
+            context->emitJump(loc, Utils::relationalToJump(binary->opr, frame.jumpIf), frame.label, t);
+            return false;
+        }
+
+        case STEP_SHORT_RHS:
+            return request(((BinaryOprNode*) node)->rhs, frame.label1 >= 0 ? STEP_SHORT_END : STEP_DONE,
+                           true, frame.label, frame.jumpIf);
+
+        case STEP_SHORT_END:
+            context->emitLabel(loc, frame.label1);
+            return false;
     }
 
-    return ret;
-}
+    //
+    // Start generating the expression
+    //
+    if (frame.branch) {
+        if (node->kind == NODE_EXPR_CONTAINER) {
+            return request(((ExprContainerNode*) node)->expr, STEP_DONE, true, frame.label, frame.jumpIf);
+        }
+
+        if (node->folded) {
+            // The direction of the branch is known at compile time
+            if (Utils::convertValue(node->constValue, node->type, DTYPE_BOOL).boolVal == frame.jumpIf) {
+                context->emitJump(loc, OPR_JMP, frame.label);
+            }
+            return false;
+        }
 
-string UnaryOprNode::generateQuad(GenerationContext* context) {
-    string ret;
-    
-    ret += expr->generateQuad(context);
+        if (node->kind == NODE_BINARY_OPR) {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+            DataType t = max(binary->lhs->type, binary->rhs->type);
+            Operator opr = binary->opr;
 
-    if (used) {
-        ret += Utils::dtypeConvQuad(expr->type, type);
+            // Compare and branch in a single instruction, except when jumping if an ordered float comparison
+            // does not hold, since its negation is not exact for NaN operands (e.g. !(a < b) is not a >= b)
+            if (Utils::isRelationalOpr(opr) &&
+                (frame.jumpIf || t != DTYPE_FLOAT || opr == OPR_EQUAL || opr == OPR_NOT_EQUAL)) {
+                return request(binary->lhs, STEP_COMPARE_RHS);
+            }
+
+            if (opr == OPR_LOGICAL_AND || opr == OPR_LOGICAL_OR) {
+                // "a && b" is false as soon as an operand is false, and "a || b" is true as soon as an operand is true
+                bool shortValue = (opr == OPR_LOGICAL_OR);
+
+                if (frame.jumpIf == shortValue) {
+                    return request(binary->lhs, STEP_SHORT_RHS, true, frame.label, frame.jumpIf);
+                }
+
+                frame.label1 = context->labelCounter++;
+                return request(binary->lhs, STEP_SHORT_RHS, true, frame.label1, shortValue);
+            }
+        }
+
+        if (node->kind == NODE_UNARY_OPR && ((UnaryOprNode*) node)->opr == OPR_LOGICAL_NOT) {
+            // Branch on the opposite truth value of the operand instead of negating it
+            return request(((UnaryOprNode*) node)->expr, STEP_DONE, true, frame.label, !frame.jumpIf);
+        }
+
+        // Otherwise, generate the value of the expression and then jump on it
     }
 
-    switch (opr) {
-        case OPR_PRE_INC:
-        case OPR_PRE_DEC:
-            ret += Utils::oprToQuad(opr, type) + "\n";
-            ret += Utils::oprToQuad(OPR_POP, type) + " " + expr->reference->alias + "\n";
+    switch (node->kind) {
+        case NODE_EXPR_CONTAINER:
+            return request(((ExprContainerNode*) node)->expr, STEP_DONE);
 
-            if (used) {
-                ret += Utils::oprToQuad(OPR_PUSH, type) + " " + expr->reference->alias + "\n";
+        case NODE_ASSIGN_OPR:
+            return request(((AssignOprNode*) node)->lhs, STEP_ASSIGN_RHS);
+
+        case NODE_BINARY_OPR: {
+            BinaryOprNode* binary = (BinaryOprNode*) node;
+
+            if (binary->folded) {
+                // Push the evaluated value of the whole constant sub-expression
+                if (binary->used) {
+                    context->emitValue(loc, binary->type, binary->constValue);
+                }
+                return false;
             }
-            break;
-        case OPR_SUF_INC:
-        case OPR_SUF_DEC:
-            if (used) {
-                ret += Utils::oprToQuad(OPR_PUSH, type) + " " + expr->reference->alias + "\n";
-            }
-            
-            ret += Utils::oprToQuad(opr, type) + "\n";
-            ret += Utils::oprToQuad(OPR_POP, type) + " " + expr->reference->alias + "\n";
-            break;
-        case OPR_U_MINUS:
-        case OPR_NOT:
-        case OPR_LOGICAL_NOT:
-            if (used) {
-                ret += Utils::oprToQuad(opr, type) + "\n";
+
+            if (binary->opr == OPR_LOGICAL_AND || binary->opr == OPR_LOGICAL_OR) {
+                // Evaluate the right operand only if the left one does not decide the result
+                frame.label1 = context->labelCounter++;
+
+                if (binary->used) {
+                    frame.label2 = context->labelCounter++;
+                    return request(binary, STEP_LOGICAL_VALUE, true, frame.label1, false);
+                }
+
+                return request(binary->lhs, STEP_LOGICAL_RHS, true, frame.label1, binary->opr == OPR_LOGICAL_OR);
             }
-            break;
+
+            return request(binary->lhs, STEP_BINARY_RHS);
+        }
+
+        default: {
+            UnaryOprNode* unary = (UnaryOprNode*) node;
+
+            if (unary->folded) {
+                // Push the evaluated value of the whole constant sub-expression
+                if (unary->used) {
+                    context->emitValue(loc, unary->type, unary->constValue);
+                }
+                return false;
+            }
+
+            return request(unary->expr, STEP_UNARY_OPR);
+        }
+    }
+}
+
+/**
+ * Generates the quadruples of the given operator expression and all the nested operators below it,
+ * using a heap-allocated work stack instead of recursion, so that deeply nested expressions
+ * (e.g. a chain of a million additions) cannot overflow the call stack.
+ *
+ * Operands that are not operators (e.g. identifiers and function calls) are generated by their own functions.
+ *
+ * @param context the generation context.
+ * @param root    the operator expression to generate.
+ * @param branch  whether to generate the expression as a branch condition or as a value.
+ * @param label   the label to jump into, if a branch condition.
+ * @param jumpIf  the truth value of the condition to jump on, if a branch condition.
+ */
+static void generateExpression(GenerationContext* context, ExpressionNode* root,
+                               bool branch = false, int label = 0, bool jumpIf = false) {
+    vector<GenerationFrame> stack;
+    stack.push_back({root, branch, label, jumpIf, STEP_START, -1, -1});
+
+    while (!stack.empty()) {
+        GenerationFrame operand;
+
+        if (!generateStep(context, stack.back(), operand)) {
+            stack.pop_back();
+        }
+        else if (isOperator(operand.node)) {
+            stack.push_back(operand);
+        }
+        else if (operand.branch) {
+            operand.node->generateBranch(context, operand.label, operand.jumpIf);
+        }
+        else {
+            operand.node->generateQuad(context);
+        }
     }
+}
 
-    return ret;
+void ExprContainerNode::generateQuad(GenerationContext* context) {
+    generateExpression(context, this);
 }
 
-string IdentifierNode::generateQuad(GenerationContext* context) {
-    string ret;
-    if (used) {
-        ret += Utils::oprToQuad(OPR_PUSH, type) + " " + reference->alias + "\n";;
+void ExprContainerNode::generateBranch(GenerationContext* context, int label, bool jumpIf) {
+    generateExpression(context, this, true, label, jumpIf);
+}
+
+void AssignOprNode::generateQuad(GenerationContext* context) {
+    generateExpression(context, this);
+}
+
+void BinaryOprNode::generateQuad(GenerationContext* context) {
+    generateExpression(context, this);
+}
+
+void BinaryOprNode::generateBranch(GenerationContext* context, int label, bool jumpIf) {
+    generateExpression(context, this, true, label, jumpIf);
+}
+
+void UnaryOprNode::generateQuad(GenerationContext* context) {
+    generateExpression(context, this);
+}
+
+void UnaryOprNode::generateBranch(GenerationContext* context, int label, bool jumpIf) {
+    generateExpression(context, this, true, label, jumpIf);
+}
+
+void IdentifierNode::generateQuad(GenerationContext* context) {
+    if (!used) {
+        return;
+    }
+
+    if (folded) {
+        context->emitValue(loc, type, constValue);
+    } else {
+        context->emitSymbol(loc, OPR_PUSH, type, reference);
     }
-    return ret;
 }
 
-string ValueNode::generateQuad(GenerationContext* context) {
-    string ret;
+void ValueNode::generateQuad(GenerationContext* context) {
     if (used) {
-        ret += Utils::oprToQuad(OPR_PUSH, type) + " " + value + "\n";
+        context->emitValue(loc, type, constValue);
     }
-    return ret;
 }
\ No newline at end of file
@@ -8,144 +8,180 @@
  * An expression container class.
  */
 struct ExprContainerNode : public ExpressionNode {
+    static const NodeKind KIND = NODE_EXPR_CONTAINER;
+
     ExpressionNode* expr;
 
     ExprContainerNode(const Location& loc, ExpressionNode* expr) : ExpressionNode(loc) {
+        this->kind = KIND;
         this->expr = expr;
     }
 
-    virtual ~ExprContainerNode() {
-        if (expr) delete expr;
-    }
-
-    virtual int getConstIntValue() {
-        return expr->getConstIntValue();
-    }
-
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
-
-    virtual string toString(int ind = 0) {
-        return expr->toString(ind);
-    }
+    /**
+     * Checks that an expression is allowed in the current scope, before analyzing it.
+     *
+     * @param context the scope context.
+     *
+     * @return {@code true} if the expression is allowed; {@code false} otherwise.
+     */
+    bool checkScope(ScopeContext* context);
+
+    /**
+     * Analyzes this operator after its operands are analyzed.
+     *
+     * @param context       the scope context.
+     * @param valueUsed     whether the value of this expression is used or not.
+     * @param operandsValid whether the operands are semantically valid or not.
+     *
+     * @return {@code true} if this expression is semantically valid; {@code false} otherwise.
+     */
+    bool analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid);
+
+    virtual void generateQuad(GenerationContext* context);
+
+    virtual void generateBranch(GenerationContext* context, int label, bool jumpIf);
+
+    virtual string toString(int ind = 0);
 };
 
 /**
  * The node class holding an assignment operator in the parse tree.
  */
 struct AssignOprNode : public ExpressionNode {
+    static const NodeKind KIND = NODE_ASSIGN_OPR;
+
     ExpressionNode* lhs;
     ExpressionNode* rhs;
 
     AssignOprNode(const Location& loc, ExpressionNode* lhs, ExpressionNode* rhs) : ExpressionNode(loc) {
+        this->kind = KIND;
         this->lhs = lhs;
         this->rhs = rhs;
     }
 
-    virtual ~AssignOprNode() {
-        if (lhs) delete lhs;
-        if (rhs) delete rhs;
-    }
-
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
+    /**
+     * Analyzes this operator after its operands are analyzed.
+     *
+     * @param context       the scope context.
+     * @param valueUsed     whether the value of this expression is used or not.
+     * @param operandsValid whether the operands are semantically valid or not.
+     *
+     * @return {@code true} if this expression is semantically valid; {@code false} otherwise.
+     */
+    bool analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid);
 
-    virtual string toString(int ind = 0) {
-        return string(ind, ' ') + "(" + lhs->toString() + " = " + rhs->toString() + ")";
-    }
+    virtual void generateQuad(GenerationContext* context);
+
+    virtual string toString(int ind = 0);
 };
 
 /**
  * The node class holding a binary operator in the parse tree.
  */
 struct BinaryOprNode : public ExpressionNode {
+    static const NodeKind KIND = NODE_BINARY_OPR;
+
     Operator opr;
     ExpressionNode* lhs;
     ExpressionNode* rhs;
 
     BinaryOprNode(const Location& loc, Operator opr, ExpressionNode* lhs, ExpressionNode* rhs) : ExpressionNode(loc) {
+        this->kind = KIND;
         this->opr = opr;
         this->lhs = lhs;
         this->rhs = rhs;
     }
 
-    virtual ~BinaryOprNode() {
-        if (lhs) delete lhs;
-        if (rhs) delete rhs;
-    }
-
-    virtual int getConstIntValue();
+    virtual void fold(ScopeContext* context);
 
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
+    /**
+     * Analyzes this operator after its operands are analyzed.
+     *
+     * @param context       the scope context.
+     * @param valueUsed     whether the value of this expression is used or not.
+     * @param operandsValid whether the operands are semantically valid or not.
+     *
+     * @return {@code true} if this expression is semantically valid; {@code false} otherwise.
+     */
+    bool analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid);
+
+    virtual void generateQuad(GenerationContext* context);
+
+    virtual void generateBranch(GenerationContext* context, int label, bool jumpIf);
 
     virtual string getOpr() {
         return "binary operator '" + Utils::oprToStr(opr) + "'";
     }
 
-    virtual string toString(int ind = 0) {
-        return string(ind, ' ') + "(" + lhs->toString() + " " + Utils::oprToStr(opr) + " " + rhs->toString() + ")";
-    }
+    virtual string toString(int ind = 0);
 };
 
 /**
  * The node class holding a unary operator in the parse tree.
  */
 struct UnaryOprNode : public ExpressionNode {
+    static const NodeKind KIND = NODE_UNARY_OPR;
+
     Operator opr;
     ExpressionNode* expr;
 
     UnaryOprNode(const Location& loc, Operator opr, ExpressionNode* expr) : ExpressionNode(loc) {
+        this->kind = KIND;
         this->opr = opr;
         this->expr = expr;
     }
 
-    virtual ~UnaryOprNode() {
-        if (expr) delete expr;
-    }
-
-    virtual int getConstIntValue();
+    virtual void fold(ScopeContext* context);
 
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
+    /**
+     * Analyzes this operator after its operands are analyzed.
+     *
+     * @param context       the scope context.
+     * @param valueUsed     whether the value of this expression is used or not.
+     * @param operandsValid whether the operands are semantically valid or not.
+     *
+     * @return {@code true} if this expression is semantically valid; {@code false} otherwise.
+     */
+    bool analyzeOperator(ScopeContext* context, bool valueUsed, bool operandsValid);
+
+    virtual void generateQuad(GenerationContext* context);
+
+    virtual void generateBranch(GenerationContext* context, int label, bool jumpIf);
 
     virtual string getOpr() {
         return "unary operator '" + Utils::oprToStr(opr) + "'";
     }
 
-    virtual string toString(int ind = 0) {
-        string ret = string(ind, ' ') + "(";
-
-        if (opr == OPR_SUF_INC || opr == OPR_SUF_DEC) {
-            ret += expr->toString() + Utils::oprToStr(opr);
-        } else {
-            ret += Utils::oprToStr(opr) + expr->toString();
-        }
-
-        ret += ")";
-        return ret;
-    }
+    virtual string toString(int ind = 0);
 };
 
 /**
  * The node class holding an identifier in the parse tree.
  */
 struct IdentifierNode : public ExpressionNode {
-    string name;
+    static const NodeKind KIND = NODE_IDENTIFIER;
+
+    InternId id;            // The interned name of the identifier
+    const string& name;
 
-    IdentifierNode(const Location& loc, const char* name) : ExpressionNode(loc) {
-        this->name = name;
+    IdentifierNode(const Location& loc, InternId id, const string& name) : ExpressionNode(loc), name(name) {
+        this->kind = KIND;
+        this->id = id;
     }
 
-    virtual int getConstIntValue();
+    virtual void fold(ScopeContext* context);
 
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         return string(ind, ' ') + name;
@@ -156,17 +192,19 @@ struct IdentifierNode : public ExpressionNode {
  * The node class holding a value in the parse tree.
  */
 struct ValueNode : public ExpressionNode {
-    string value;
+    static const NodeKind KIND = NODE_VALUE;
 
-    ValueNode(const Location& loc, DataType type, const char* value) : ExpressionNode(loc) {
+    const string& value;    // The interned text of the value
+
+    ValueNode(const Location& loc, DataType type, const string& value) : ExpressionNode(loc), value(value) {
+        this->kind = KIND;
         this->type = type;
-        this->value = value;
         this->constant = true;
+        this->folded = true;
+        this->constValue = Utils::strToValue(value, type);
     }
 
-    virtual int getConstIntValue();
-
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         return string(ind, ' ') + value;
@@ -0,0 +1,28 @@
+#include "../parse_tree.h"
+#include "../node_visitor.h"
+
+
+//
+// The expressions are printed by a non-recursive pass,
+// so that deeply nested expressions cannot overflow the call stack
+//
+
+string ExprContainerNode::toString(int ind) {
+    return string(ind, ' ') + ExpressionPrinter().print(this);
+}
+
+string AssignOprNode::toString(int ind) {
+    return string(ind, ' ') + ExpressionPrinter().print(this);
+}
+
+string BinaryOprNode::toString(int ind) {
+    return string(ind, ' ') + ExpressionPrinter().print(this);
+}
+
+string UnaryOprNode::toString(int ind) {
+    return string(ind, ' ') + ExpressionPrinter().print(this);
+}
+
+string FunctionCallNode::toString(int ind) {
+    return string(ind, ' ') + ExpressionPrinter().print(this);
+}
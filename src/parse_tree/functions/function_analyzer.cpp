@@ -8,13 +8,23 @@ bool FunctionNode::analyze(ScopeContext* context) {
         return false;
     }
 
-    bool ret = true;
+    bool ret = declare(context);
+    ret &= analyzeBody(context);
+    return ret;
+}
 
+bool FunctionNode::declare(ScopeContext* context) {
     if (!context->declareSymbol(this)) {
         context->log("'" + declaredHeader() + "' redeclared", ident->loc, LOG_ERROR);
-        ret = false;
+        return false;
     }
 
+    return true;
+}
+
+bool FunctionNode::analyzeBody(ScopeContext* context) {
+    bool ret = true;
+
     context->addScope(SCOPE_FUNCTION, this);
 
     context->declareFuncParams = true;
@@ -33,8 +43,8 @@ bool FunctionNode::analyze(ScopeContext* context) {
 bool FunctionCallNode::analyze(ScopeContext* context, bool valueUsed) {
     bool ret = true;
 
-    DeclarationNode* ptr = context->getSymbol(ident->name);
-    func = dynamic_cast<FunctionNode*>(ptr);
+    DeclarationNode* ptr = context->getSymbol(ident->id);
+    func = nodeCast<FunctionNode>(ptr);
 
     if (ptr == NULL) {
         context->log("'" + ident->name + "' was not declared in this scope", loc, LOG_ERROR);
@@ -2,45 +2,38 @@
 #include "../../context/generation_context.h"
 
 
-string FunctionNode::generateQuad(GenerationContext* context) {
-    string ret;
-
-    ret += "PROC " + alias + "\n";
+void FunctionNode::generateQuad(GenerationContext* context) {
+    context->beginProc(this);
     context->declareFuncParams = true;
 
     for (int i = 0; i < paramList.size(); ++i) {
-        ret += paramList[i]->generateQuad(context);
+        paramList[i]->generateQuad(context);
     }
 
     context->declareFuncParams = false;
-    ret += body->generateQuad(context);
-    ret += "ENDP " + alias + "\n";
-
-    return ret;
+    body->generateQuad(context);
+    context->endProc();
 }
 
-string FunctionCallNode::generateQuad(GenerationContext* context) {
-    string ret;
-
+void FunctionCallNode::generateQuad(GenerationContext* context) {
     for (int i = (int) argList.size() - 1; i >= 0; --i) {
-        ret += argList[i]->generateQuad(context);
-        ret += Utils::dtypeConvQuad(argList[i]->type, func->paramList[i]->type->type);
+        argList[i]->generateQuad(context);
+        context->emitConv(loc, argList[i]->type, func->paramList[i]->type->type);
     }
 
-    ret += "CALL " + func->alias + "\n";
+    context->emitCall(loc, func);
 
-    return ret;
+    if (!used && type != DTYPE_VOID) {
+        // Discard the unused return value to keep the stack balanced
+        context->emitOpr(loc, OPR_POP, type);
+    }
 }
 
-string ReturnStmtNode::generateQuad(GenerationContext* context) {
-    string ret;
-
+void ReturnStmtNode::generateQuad(GenerationContext* context) {
     if (value) {
-        ret += value->generateQuad(context);
-        ret += Utils::dtypeConvQuad(value->type, func->type->type);
+        value->generateQuad(context);
+        context->emitConv(loc, value->type, func->type->type);
     }
 
-    ret += "RET\n";
-
-    return ret;
+    context->emitRet(loc);
 }
\ No newline at end of file
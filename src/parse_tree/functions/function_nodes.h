@@ -9,11 +9,14 @@
  * The node class holding a function in the parse tree.
  */
 struct FunctionNode : public DeclarationNode {
+    static const NodeKind KIND = NODE_FUNCTION;
+
     VarList paramList;
     BlockNode* body;
 
     FunctionNode(TypeNode* type, IdentifierNode* ident, const VarList& paramList, BlockNode* body)
             : DeclarationNode(type->loc) {
+        this->kind = KIND;
         this->type = type;
         this->ident = ident;
         this->paramList = paramList;
@@ -21,19 +24,27 @@ struct FunctionNode : public DeclarationNode {
         this->initialized = true;
     }
 
-    virtual ~FunctionNode() {
-        if (type) delete type;
-        if (ident) delete ident;
-        if (body) delete body;
-
-        for (int i = 0; i < paramList.size(); ++i) {
-            delete paramList[i];
-        }
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    /**
+     * Declares this function in the current scope of the given context.
+     *
+     * @param context the scope context.
+     *
+     * @return {@code true} if declared successfully; {@code false} if already declared.
+     */
+    bool declare(ScopeContext* context);
+
+    /**
+     * Analyzes the parameters and the body of this function in the given context.
+     *
+     * @param context the scope context, in which this function is already declared.
+     *
+     * @return {@code true} if the parameters and the body are valid; {@code false} otherwise.
+     */
+    bool analyzeBody(ScopeContext* context);
+
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + type->toString() + " " + ident->toString() + "(";
@@ -68,55 +79,42 @@ struct FunctionNode : public DeclarationNode {
  * The node class holding a function call expression in the parse tree.
  */
 struct FunctionCallNode : public ExpressionNode {
+    static const NodeKind KIND = NODE_FUNCTION_CALL;
+
     IdentifierNode* ident;
     ExprList argList;
     FunctionNode* func;
 
     FunctionCallNode(IdentifierNode* ident, const ExprList& argList) : ExpressionNode(ident->loc) {
+        this->kind = KIND;
         this->ident = ident;
         this->argList = argList;
     }
 
-    virtual ~FunctionCallNode() {
-        if (ident) delete ident;
-
-        for (int i = 0; i < argList.size(); ++i) {
-            delete argList[i];
-        }
-    }
-
     virtual bool analyze(ScopeContext* context, bool valueUsed);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
-    virtual string toString(int ind = 0) {
-        string ret = string(ind, ' ') + ident->name + "(";
-        for (int i = 0; i < argList.size(); ++i) {
-            ret += (i > 0 ? ", " : "") + argList[i]->toString();
-        }
-        ret += ")";
-        return ret;
-    }
+    virtual string toString(int ind = 0);
 };
 
 /**
  * The node class holding a return statement in the parse tree.
  */
 struct ReturnStmtNode : public StatementNode {
+    static const NodeKind KIND = NODE_RETURN;
+
     ExpressionNode* value;
     FunctionNode* func;
 
     ReturnStmtNode(const Location& loc, ExpressionNode* value) : StatementNode(loc) {
+        this->kind = KIND;
         this->value = value;
     }
 
-    virtual ~ReturnStmtNode() {
-        if (value) delete value;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "return";
@@ -0,0 +1,554 @@
+#ifndef __NODE_VISITOR_H_
+#define __NODE_VISITOR_H_
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parse_tree.h"
+
+
+/**
+ * The base class of the passes traversing the parse tree.
+ *
+ * Nodes are dispatched by their kind into the visit function of their class,
+ * so that a new pass can be added without adding a virtual function to every node.
+ * By default, every visit function falls back to {@code visitNode}, which visits the children of the node
+ * in the order of the source code. A pass overrides the functions of the nodes it is interested in,
+ * and calls {@code visitChildren} to continue the traversal below them if needed.
+ * Once a node and all the nodes queued by its visit function are visited, its leave function is called,
+ * which falls back to {@code leaveNode}, so that a pass can act after the children of a node as well.
+ *
+ * The traversal does not recurse, so that deeply nested trees cannot overflow the call stack:
+ * a node visited from within a visit function is only queued on a heap-allocated work stack,
+ * and is visited after that function returns. The nodes queued by the same visit function
+ * are visited in the order they were queued, each along with its own subtree, before the next one.
+ * The leave function of a node is queued on the same stack, below the nodes queued by its visit function.
+ */
+struct NodeVisitor {
+    vector<pair<Node*, bool>> pending;  // The nodes queued to be visited (or left, if paired with true), the next one at the back
+    bool visiting = false;              // Whether a traversal is in progress or not
+
+    virtual ~NodeVisitor() {}
+
+    /**
+     * Visits the given node by calling the visit function of its class,
+     * or queues it if called from within a visit or a leave function.
+     *
+     * @param node the node to visit, or {@code NULL} to do nothing.
+     */
+    void visit(Node* node) {
+        if (node == NULL) {
+            return;
+        }
+
+        pending.push_back({ node, false });
+
+        if (visiting) {
+            return;
+        }
+
+        visiting = true;
+
+        while (!pending.empty()) {
+            pair<Node*, bool> next = pending.back();
+            pending.pop_back();
+
+            // Leave the node after the nodes its visit function queues
+            if (!next.second) {
+                pending.push_back({ next.first, true });
+            }
+
+            size_t queued = pending.size();
+
+            if (next.second) {
+                dispatchLeave(next.first);
+            } else {
+                dispatch(next.first);
+            }
+
+            // Pop the nodes queued by the visit or leave function in the order they were queued
+            reverse(pending.begin() + queued, pending.end());
+        }
+
+        visiting = false;
+    }
+
+    /**
+     * Calls the visit function of the class of the given node.
+     *
+     * @param node the node to visit.
+     */
+    void dispatch(Node* node) {
+        switch (node->kind) {
+            case NODE_STATEMENT:
+                visitStatement((StatementNode*) node);
+                break;
+            case NODE_ERROR:
+                visitError((ErrorNode*) node);
+                break;
+            case NODE_TYPE:
+                visitType((TypeNode*) node);
+                break;
+            case NODE_BLOCK:
+                visitBlock((BlockNode*) node);
+                break;
+            case NODE_VAR_DECL:
+                visitVarDeclaration((VarDeclarationNode*) node);
+                break;
+            case NODE_MULTI_VAR_DECL:
+                visitMultiVarDeclaration((MultiVarDeclarationNode*) node);
+                break;
+            case NODE_IF:
+                visitIf((IfNode*) node);
+                break;
+            case NODE_CASE_LABEL:
+                visitCaseLabel((CaseLabelNode*) node);
+                break;
+            case NODE_SWITCH:
+                visitSwitch((SwitchNode*) node);
+                break;
+            case NODE_WHILE:
+                visitWhile((WhileNode*) node);
+                break;
+            case NODE_DO_WHILE:
+                visitDoWhile((DoWhileNode*) node);
+                break;
+            case NODE_FOR:
+                visitFor((ForNode*) node);
+                break;
+            case NODE_BREAK:
+                visitBreak((BreakStmtNode*) node);
+                break;
+            case NODE_CONTINUE:
+                visitContinue((ContinueStmtNode*) node);
+                break;
+            case NODE_FUNCTION:
+                visitFunction((FunctionNode*) node);
+                break;
+            case NODE_FUNCTION_CALL:
+                visitFunctionCall((FunctionCallNode*) node);
+                break;
+            case NODE_RETURN:
+                visitReturn((ReturnStmtNode*) node);
+                break;
+            case NODE_EXPR_CONTAINER:
+                visitExprContainer((ExprContainerNode*) node);
+                break;
+            case NODE_ASSIGN_OPR:
+                visitAssignOpr((AssignOprNode*) node);
+                break;
+            case NODE_BINARY_OPR:
+                visitBinaryOpr((BinaryOprNode*) node);
+                break;
+            case NODE_UNARY_OPR:
+                visitUnaryOpr((UnaryOprNode*) node);
+                break;
+            case NODE_IDENTIFIER:
+                visitIdentifier((IdentifierNode*) node);
+                break;
+            case NODE_VALUE:
+                visitValue((ValueNode*) node);
+                break;
+        }
+    }
+
+    /**
+     * Calls the leave function of the class of the given node.
+     *
+     * @param node the node to leave.
+     */
+    void dispatchLeave(Node* node) {
+        switch (node->kind) {
+            case NODE_STATEMENT:
+                leaveStatement((StatementNode*) node);
+                break;
+            case NODE_ERROR:
+                leaveError((ErrorNode*) node);
+                break;
+            case NODE_TYPE:
+                leaveType((TypeNode*) node);
+                break;
+            case NODE_BLOCK:
+                leaveBlock((BlockNode*) node);
+                break;
+            case NODE_VAR_DECL:
+                leaveVarDeclaration((VarDeclarationNode*) node);
+                break;
+            case NODE_MULTI_VAR_DECL:
+                leaveMultiVarDeclaration((MultiVarDeclarationNode*) node);
+                break;
+            case NODE_IF:
+                leaveIf((IfNode*) node);
+                break;
+            case NODE_CASE_LABEL:
+                leaveCaseLabel((CaseLabelNode*) node);
+                break;
+            case NODE_SWITCH:
+                leaveSwitch((SwitchNode*) node);
+                break;
+            case NODE_WHILE:
+                leaveWhile((WhileNode*) node);
+                break;
+            case NODE_DO_WHILE:
+                leaveDoWhile((DoWhileNode*) node);
+                break;
+            case NODE_FOR:
+                leaveFor((ForNode*) node);
+                break;
+            case NODE_BREAK:
+                leaveBreak((BreakStmtNode*) node);
+                break;
+            case NODE_CONTINUE:
+                leaveContinue((ContinueStmtNode*) node);
+                break;
+            case NODE_FUNCTION:
+                leaveFunction((FunctionNode*) node);
+                break;
+            case NODE_FUNCTION_CALL:
+                leaveFunctionCall((FunctionCallNode*) node);
+                break;
+            case NODE_RETURN:
+                leaveReturn((ReturnStmtNode*) node);
+                break;
+            case NODE_EXPR_CONTAINER:
+                leaveExprContainer((ExprContainerNode*) node);
+                break;
+            case NODE_ASSIGN_OPR:
+                leaveAssignOpr((AssignOprNode*) node);
+                break;
+            case NODE_BINARY_OPR:
+                leaveBinaryOpr((BinaryOprNode*) node);
+                break;
+            case NODE_UNARY_OPR:
+                leaveUnaryOpr((UnaryOprNode*) node);
+                break;
+            case NODE_IDENTIFIER:
+                leaveIdentifier((IdentifierNode*) node);
+                break;
+            case NODE_VALUE:
+                leaveValue((ValueNode*) node);
+                break;
+        }
+    }
+
+    /**
+     * Visits the children of the given node in the order of the source code.
+     *
+     * @param node the node whose children to visit.
+     */
+    void visitChildren(Node* node) {
+        switch (node->kind) {
+            case NODE_BLOCK: {
+                BlockNode* block = (BlockNode*) node;
+                for (int i = 0; i < block->statements.size(); ++i) {
+                    visit(block->statements[i]);
+                }
+                break;
+            }
+            case NODE_VAR_DECL: {
+                VarDeclarationNode* var = (VarDeclarationNode*) node;
+                visit(var->type);
+                visit(var->ident);
+                visit(var->value);
+                break;
+            }
+            case NODE_MULTI_VAR_DECL: {
+                MultiVarDeclarationNode* multi = (MultiVarDeclarationNode*) node;
+                for (int i = 0; i < multi->vars.size(); ++i) {
+                    visit(multi->vars[i]);
+                }
+                break;
+            }
+            case NODE_IF: {
+                IfNode* ifNode = (IfNode*) node;
+                visit(ifNode->cond);
+                visit(ifNode->ifBody);
+                visit(ifNode->elseBody);
+                break;
+            }
+            case NODE_CASE_LABEL: {
+                CaseLabelNode* label = (CaseLabelNode*) node;
+                visit(label->expr);
+                visit(label->stmt);
+                break;
+            }
+            case NODE_SWITCH: {
+                SwitchNode* switchNode = (SwitchNode*) node;
+                visit(switchNode->cond);
+                visit(switchNode->body);
+                break;
+            }
+            case NODE_WHILE: {
+                WhileNode* loop = (WhileNode*) node;
+                visit(loop->cond);
+                visit(loop->body);
+                break;
+            }
+            case NODE_DO_WHILE: {
+                DoWhileNode* loop = (DoWhileNode*) node;
+                visit(loop->body);
+                visit(loop->cond);
+                break;
+            }
+            case NODE_FOR: {
+                ForNode* loop = (ForNode*) node;
+                visit(loop->initStmt);
+                visit(loop->cond);
+                visit(loop->inc);
+                visit(loop->body);
+                break;
+            }
+            case NODE_FUNCTION: {
+                FunctionNode* func = (FunctionNode*) node;
+                visit(func->type);
+                visit(func->ident);
+                for (int i = 0; i < func->paramList.size(); ++i) {
+                    visit(func->paramList[i]);
+                }
+                visit(func->body);
+                break;
+            }
+            case NODE_FUNCTION_CALL: {
+                FunctionCallNode* call = (FunctionCallNode*) node;
+                visit(call->ident);
+                for (int i = 0; i < call->argList.size(); ++i) {
+                    visit(call->argList[i]);
+                }
+                break;
+            }
+            case NODE_RETURN:
+                visit(((ReturnStmtNode*) node)->value);
+                break;
+            case NODE_EXPR_CONTAINER:
+                visit(((ExprContainerNode*) node)->expr);
+                break;
+            case NODE_ASSIGN_OPR:
+                visit(((AssignOprNode*) node)->lhs);
+                visit(((AssignOprNode*) node)->rhs);
+                break;
+            case NODE_BINARY_OPR:
+                visit(((BinaryOprNode*) node)->lhs);
+                visit(((BinaryOprNode*) node)->rhs);
+                break;
+            case NODE_UNARY_OPR:
+                visit(((UnaryOprNode*) node)->expr);
+                break;
+            default:
+                break;
+        }
+    }
+
+    /**
+     * Visits a node whose class has no specific visit function in this pass.
+     *
+     * @param node the node to visit.
+     */
+    virtual void visitNode(Node* node) {
+        visitChildren(node);
+    }
+
+    /**
+     * Leaves a node whose class has no specific leave function in this pass.
+     *
+     * @param node the node to leave.
+     */
+    virtual void leaveNode(Node* node) {
+
+    }
+
+    //
+    // Visit functions of each node class
+    //
+    virtual void visitStatement(StatementNode* node) { visitNode(node); }
+    virtual void visitError(ErrorNode* node) { visitNode(node); }
+    virtual void visitType(TypeNode* node) { visitNode(node); }
+    virtual void visitBlock(BlockNode* node) { visitNode(node); }
+    virtual void visitVarDeclaration(VarDeclarationNode* node) { visitNode(node); }
+    virtual void visitMultiVarDeclaration(MultiVarDeclarationNode* node) { visitNode(node); }
+    virtual void visitIf(IfNode* node) { visitNode(node); }
+    virtual void visitCaseLabel(CaseLabelNode* node) { visitNode(node); }
+    virtual void visitSwitch(SwitchNode* node) { visitNode(node); }
+    virtual void visitWhile(WhileNode* node) { visitNode(node); }
+    virtual void visitDoWhile(DoWhileNode* node) { visitNode(node); }
+    virtual void visitFor(ForNode* node) { visitNode(node); }
+    virtual void visitBreak(BreakStmtNode* node) { visitNode(node); }
+    virtual void visitContinue(ContinueStmtNode* node) { visitNode(node); }
+    virtual void visitFunction(FunctionNode* node) { visitNode(node); }
+    virtual void visitFunctionCall(FunctionCallNode* node) { visitNode(node); }
+    virtual void visitReturn(ReturnStmtNode* node) { visitNode(node); }
+    virtual void visitExprContainer(ExprContainerNode* node) { visitNode(node); }
+    virtual void visitAssignOpr(AssignOprNode* node) { visitNode(node); }
+    virtual void visitBinaryOpr(BinaryOprNode* node) { visitNode(node); }
+    virtual void visitUnaryOpr(UnaryOprNode* node) { visitNode(node); }
+    virtual void visitIdentifier(IdentifierNode* node) { visitNode(node); }
+    virtual void visitValue(ValueNode* node) { visitNode(node); }
+
+    //
+    // Leave functions of each node class
+    //
+    virtual void leaveStatement(StatementNode* node) { leaveNode(node); }
+    virtual void leaveError(ErrorNode* node) { leaveNode(node); }
+    virtual void leaveType(TypeNode* node) { leaveNode(node); }
+    virtual void leaveBlock(BlockNode* node) { leaveNode(node); }
+    virtual void leaveVarDeclaration(VarDeclarationNode* node) { leaveNode(node); }
+    virtual void leaveMultiVarDeclaration(MultiVarDeclarationNode* node) { leaveNode(node); }
+    virtual void leaveIf(IfNode* node) { leaveNode(node); }
+    virtual void leaveCaseLabel(CaseLabelNode* node) { leaveNode(node); }
+    virtual void leaveSwitch(SwitchNode* node) { leaveNode(node); }
+    virtual void leaveWhile(WhileNode* node) { leaveNode(node); }
+    virtual void leaveDoWhile(DoWhileNode* node) { leaveNode(node); }
+    virtual void leaveFor(ForNode* node) { leaveNode(node); }
+    virtual void leaveBreak(BreakStmtNode* node) { leaveNode(node); }
+    virtual void leaveContinue(ContinueStmtNode* node) { leaveNode(node); }
+    virtual void leaveFunction(FunctionNode* node) { leaveNode(node); }
+    virtual void leaveFunctionCall(FunctionCallNode* node) { leaveNode(node); }
+    virtual void leaveReturn(ReturnStmtNode* node) { leaveNode(node); }
+    virtual void leaveExprContainer(ExprContainerNode* node) { leaveNode(node); }
+    virtual void leaveAssignOpr(AssignOprNode* node) { leaveNode(node); }
+    virtual void leaveBinaryOpr(BinaryOprNode* node) { leaveNode(node); }
+    virtual void leaveUnaryOpr(UnaryOprNode* node) { leaveNode(node); }
+    virtual void leaveIdentifier(IdentifierNode* node) { leaveNode(node); }
+    virtual void leaveValue(ValueNode* node) { leaveNode(node); }
+};
+
+/**
+ * Pass counting the nodes of each kind in a parse tree.
+ */
+struct NodeCounter : public NodeVisitor {
+    size_t total = 0;                                       // The total number of visited nodes
+    size_t counts[NODE_VALUE - NODE_STATEMENT + 1] = {};    // The number of visited nodes of each kind
+
+    /**
+     * Counts the nodes of the given tree.
+     *
+     * @param root the root of the tree.
+     */
+    void count(Node* root) {
+        visit(root);
+    }
+
+    virtual void visitNode(Node* node) {
+        ++total;
+        ++counts[node->kind - NODE_STATEMENT];
+        visitChildren(node);
+    }
+};
+
+/**
+ * Pass printing an expression tree as text (e.g. {@code ((a + 1) * f(b, c))}),
+ * wrapping each operator in parentheses.
+ *
+ * The separators between the operands (e.g. the binary operators and the commas of the call arguments)
+ * are written when entering the operands, and the closing parentheses when leaving the operators.
+ */
+struct ExpressionPrinter : public NodeVisitor {
+    string out;                         // The printed text
+    vector<pair<Node*, int>> operators; // The nodes being printed, paired with the number of their operands entered so far
+
+    /**
+     * Prints the given expression tree.
+     *
+     * @param root the root of the tree.
+     *
+     * @return the printed text.
+     */
+    string print(Node* root) {
+        out.clear();
+        visit(root);
+        return out;
+    }
+
+    virtual void visitNode(Node* node) {
+        if (!operators.empty() && operators.back().second++ > 0) {
+            writeSeparator(operators.back().first);
+        }
+
+        operators.push_back({ node, 0 });
+
+        switch (node->kind) {
+            case NODE_EXPR_CONTAINER:
+                visitChildren(node);
+                break;
+            case NODE_ASSIGN_OPR:
+            case NODE_BINARY_OPR:
+                out += '(';
+                visitChildren(node);
+                break;
+            case NODE_UNARY_OPR: {
+                UnaryOprNode* unary = (UnaryOprNode*) node;
+                out += '(';
+
+                if (unary->opr != OPR_SUF_INC && unary->opr != OPR_SUF_DEC) {
+                    out += Utils::oprToStr(unary->opr);
+                }
+
+                visit(unary->expr);
+                break;
+            }
+            case NODE_FUNCTION_CALL: {
+                FunctionCallNode* call = (FunctionCallNode*) node;
+                out += call->ident->name;
+                out += '(';
+
+                for (int i = 0; i < call->argList.size(); ++i) {
+                    visit(call->argList[i]);
+                }
+                break;
+            }
+            default:
+                out += ((ExpressionNode*) node)->toString();
+                break;
+        }
+    }
+
+    virtual void leaveNode(Node* node) {
+        operators.pop_back();
+
+        switch (node->kind) {
+            case NODE_UNARY_OPR: {
+                UnaryOprNode* unary = (UnaryOprNode*) node;
+
+                if (unary->opr == OPR_SUF_INC || unary->opr == OPR_SUF_DEC) {
+                    out += Utils::oprToStr(unary->opr);
+                }
+
+                out += ')';
+                break;
+            }
+            case NODE_ASSIGN_OPR:
+            case NODE_BINARY_OPR:
+            case NODE_FUNCTION_CALL:
+                out += ')';
+                break;
+            default:
+                break;
+        }
+    }
+
+    /**
+     * Writes the separator preceding the next operand of the given node.
+     *
+     * @param node the node whose operand is entered.
+     */
+    void writeSeparator(Node* node) {
+        switch (node->kind) {
+            case NODE_ASSIGN_OPR:
+                out += " = ";
+                break;
+            case NODE_BINARY_OPR:
+                out += ' ';
+                out += Utils::oprToStr(((BinaryOprNode*) node)->opr);
+                out += ' ';
+                break;
+            case NODE_FUNCTION_CALL:
+                out += ", ";
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -2,37 +2,25 @@
 #include "../../context/generation_context.h"
 
 
-string BlockNode::generateQuad(GenerationContext* context) {
-    string ret;
-
+void BlockNode::generateQuad(GenerationContext* context) {
     for (int i = 0; i < statements.size(); ++i) {
-        ret += statements[i]->generateQuad(context);
+        statements[i]->generateQuad(context);
     }
-    
-    return ret;
 }
 
-string VarDeclarationNode::generateQuad(GenerationContext* context) {
-    string ret;
-
+void VarDeclarationNode::generateQuad(GenerationContext* context) {
     if (value) {
-        ret += value->generateQuad(context);
-        ret += Utils::dtypeConvQuad(value->type, type->type);
+        value->generateQuad(context);
+        context->emitConv(loc, value->type, type->type);
     }
 
     if (value || context->declareFuncParams) {
-        ret += Utils::oprToQuad(OPR_POP, type->type) + " " + alias + "\n";
+        context->emitSymbol(loc, OPR_POP, type->type, this);
     }
-
-    return ret;
 }
 
-string MultiVarDeclarationNode::generateQuad(GenerationContext* context) {
-    string ret;
-
+void MultiVarDeclarationNode::generateQuad(GenerationContext* context) {
     for (int i = 0; i < vars.size(); ++i) {
-        ret += vars[i]->generateQuad(context);
+        vars[i]->generateQuad(context);
     }
-
-    return ret;
 }
\ No newline at end of file
@@ -9,25 +9,26 @@
  * The node class holding a block of code in the parse tree.
  */
 struct BlockNode : public StatementNode {
+    static const NodeKind KIND = NODE_BLOCK;
+
     StmtList statements;
 
-    BlockNode() {}
+    BlockNode() {
+        this->kind = KIND;
+    }
 
-    BlockNode(const Location& loc) : StatementNode(loc) {}
+    BlockNode(const Location& loc) : StatementNode(loc) {
+        this->kind = KIND;
+    }
 
     BlockNode(const Location& loc, const StmtList& statements) : StatementNode(loc) {
+        this->kind = KIND;
         this->statements = statements;
     }
 
-    virtual ~BlockNode() {
-        for (int i = 0; i < statements.size(); ++i) {
-            delete statements[i];
-        }
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + "{\n";
@@ -43,11 +44,14 @@ struct BlockNode : public StatementNode {
  * The node class holding a variable or constant declaration statement in the parse tree.
  */
 struct VarDeclarationNode : public DeclarationNode {
+    static const NodeKind KIND = NODE_VAR_DECL;
+
     ExpressionNode* value;
     bool constant;
 
     VarDeclarationNode(TypeNode* type, IdentifierNode* ident, ExpressionNode* value = NULL, bool constant = false)
             : DeclarationNode(type->loc) {
+        this->kind = KIND;
         this->type = type;
         this->ident = ident;
         this->value = value;
@@ -55,15 +59,9 @@ struct VarDeclarationNode : public DeclarationNode {
         this->initialized = (value != NULL);
     }
 
-    virtual ~VarDeclarationNode() {
-        if (type) delete type;
-        if (ident) delete ident;
-        if (value) delete value;
-    }
-
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + declaredHeader();
@@ -86,30 +84,31 @@ struct VarDeclarationNode : public DeclarationNode {
  * The node class holding multiple variables or constants declaration statement in the parse tree.
  */
 struct MultiVarDeclarationNode : public StatementNode {
+    static const NodeKind KIND = NODE_MULTI_VAR_DECL;
+
     TypeNode* type;
     VarList vars;
     bool constant;
 
     MultiVarDeclarationNode(VarDeclarationNode* var) {
-        this->type = new TypeNode(*(var->type));
+        this->kind = KIND;
+        this->type = var->type;
         this->constant = var->constant;
         this->vars.push_back(var);
     }
 
-    virtual ~MultiVarDeclarationNode() {
-        delete type;
-        for (int i = 0; i < vars.size(); ++i) {
-            delete vars[i];
-        }
-    }
-
-    virtual void addVar(IdentifierNode* ident, ExpressionNode* value = NULL) {
-        vars.push_back(new VarDeclarationNode(new TypeNode(*type), ident, value, constant));
+    /**
+     * Adds a variable to this declaration statement.
+     *
+     * @param var the variable declaration node, sharing the type node of this statement.
+     */
+    virtual void addVar(VarDeclarationNode* var) {
+        vars.push_back(var);
     }
 
     virtual bool analyze(ScopeContext* context);
 
-    virtual string generateQuad(GenerationContext* context);
+    virtual void generateQuad(GenerationContext* context);
 
     virtual string toString(int ind = 0) {
         string ret = string(ind, ' ') + type->toString();
@@ -0,0 +1,706 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "quad_image.h"
+
+
+/**
+ * Returns the index of the given primitive data type in the typed opcodes.
+ *
+ * @param type the data type.
+ *
+ * @return the index of the type, or -1 if not a primitive type.
+ */
+static int typeIndex(DataType type) {
+    switch (type) {
+        case DTYPE_BOOL:
+            return 0;
+        case DTYPE_CHAR:
+            return 1;
+        case DTYPE_INT:
+            return 2;
+        case DTYPE_FLOAT:
+            return 3;
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the size of the given number of records after padding it to the image alignment.
+ */
+static uint32_t alignedSize(size_t count, size_t recordSize) {
+    size_t size = count * recordSize;
+    return (uint32_t) ((size + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT);
+}
+
+// =====================================================================================================
+// Binary Writer
+// =============
+
+/**
+ * Returns the number of values the given instruction pops off the operand stack, and the number of values it pushes onto it.
+ * The values consumed and produced by the callee of a call instruction are not included.
+ *
+ * @param opcode the opcode of the instruction.
+ * @param pops   the number of popped values to set.
+ * @param pushes the number of pushed values to set.
+ */
+static void stackEffect(uint16_t opcode, int& pops, int& pushes) {
+    pops = pushes = 0;
+
+    switch (opcode) {
+        case IMG_PUSH_IMM:
+        case IMG_PUSH_LOCAL:
+        case IMG_PUSH_GLOBAL:
+            pushes = 1;
+            return;
+        case IMG_POP_LOCAL:
+        case IMG_POP_GLOBAL:
+        case IMG_POP:
+        case IMG_JTAB:
+            pops = 1;
+            return;
+        case IMG_DUP:
+            pops = 1;
+            pushes = 2;
+            return;
+        case IMG_JMP:
+        case IMG_CALL:
+        case IMG_RET:
+        case IMG_CASE:
+            return;
+    }
+
+    if (opcode >= IMG_JGT) {
+        pops = 2;                   // Compare-and-branch instructions
+    } else if (opcode >= IMG_NOT) {
+        pops = pushes = 1;          // Unary instructions and conversions
+    } else if (opcode >= IMG_ADD) {
+        pops = 2;                   // Binary instructions and comparisons
+        pushes = 1;
+    } else {
+        pops = 1;                   // Conditional jumps
+    }
+}
+
+QuadBinaryWriter::QuadBinaryWriter(ostream& out) : out(out) {
+    // Reserve the first procedure for the global initialization code
+    procs.push_back(ImageProc());
+}
+
+void QuadBinaryWriter::write(const QuadProc& proc) {
+    if (proc.name.empty()) {
+        translate(proc, initCode, initLocalIds);
+        return;
+    }
+
+    ImageProc p;
+    p.name = addString(proc.name);
+    p.codeStart = (uint32_t) code.size();
+    p.symbolStart = (uint32_t) locals.size();
+
+    // Register the procedure before translating it to allow recursive calls
+    procIds[proc.name] = (int) procs.size();
+
+    unordered_map<string, int> localIds;
+    translate(proc, code, localIds);
+    code.push_back(makeRet());
+
+    p.codeSize = (uint32_t) code.size() - p.codeStart;
+    p.frameSize = (uint32_t) localIds.size();
+    procs.push_back(p);
+}
+
+void QuadBinaryWriter::finish() {
+    // Append the global initialization code as the first procedure
+    ImageProc& init = procs[0];
+    init.name = addString("");
+    init.codeStart = (uint32_t) code.size();
+    init.codeSize = (uint32_t) initCode.size() + 1;
+    init.symbolStart = (uint32_t) locals.size();
+    init.frameSize = (uint32_t) initLocalIds.size();
+
+    code.insert(code.end(), initCode.begin(), initCode.end());
+    code.push_back(makeRet());
+    locals.resize(locals.size() + initLocalIds.size());
+
+    for (auto& it : initLocalIds) {
+        locals[init.symbolStart + it.second].name = addString(it.first);
+    }
+
+    // Place global variables before local variables in the symbol table
+    for (int i = 0; i < procs.size(); ++i) {
+        procs[i].symbolStart += (uint32_t) globals.size();
+    }
+
+    vector<ImageSymbol> symbols(globals);
+    symbols.insert(symbols.end(), locals.begin(), locals.end());
+
+    // Fill the header
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, 4);
+
+    auto it = procIds.find("main");
+
+    header.version = IMAGE_VERSION;
+    header.procCount = (uint32_t) procs.size();
+    header.symbolCount = (uint32_t) symbols.size();
+    header.globalCount = (uint32_t) globals.size();
+    header.codeCount = (uint32_t) code.size();
+    header.stringsSize = (uint32_t) strings.size();
+    header.mainProc = (it != procIds.end() ? it->second : -1);
+    header.procsOffset = alignedSize(1, sizeof(ImageHeader));
+    header.symbolsOffset = header.procsOffset + alignedSize(procs.size(), sizeof(ImageProc));
+    header.codeOffset = header.symbolsOffset + alignedSize(symbols.size(), sizeof(ImageSymbol));
+    header.stringsOffset = header.codeOffset + alignedSize(code.size(), sizeof(ImageInstr));
+
+    // Write the sections
+    vector<char> image(header.stringsOffset + strings.size(), 0);
+    memcpy(&image[0], &header, sizeof(header));
+    memcpy(&image[header.procsOffset], procs.data(), procs.size() * sizeof(ImageProc));
+    memcpy(&image[header.symbolsOffset], symbols.data(), symbols.size() * sizeof(ImageSymbol));
+    memcpy(&image[header.codeOffset], code.data(), code.size() * sizeof(ImageInstr));
+    memcpy(&image[header.stringsOffset], strings.data(), strings.size());
+
+    out.write(image.data(), image.size());
+}
+
+void QuadBinaryWriter::translate(const QuadProc& proc, vector<ImageInstr>& dst, unordered_map<string, int>& localIds) {
+    // Jump targets are relative to the beginning of the procedure,
+    // which is the beginning of the destination for the global initialization code
+    int procStart = (&dst == &initCode ? 0 : (int) dst.size());
+
+    // Resolve labels into instruction offsets
+    unordered_map<int, int> labels;
+    int pc = (int) dst.size() - procStart;
+
+    for (int i = 0; i < proc.quads.size(); ++i) {
+        if (proc.quads[i].opr == OPR_LABEL) {
+            labels[proc.quads[i].operand.label] = pc;
+        } else {
+            // Jump tables take an extra instruction for the default entry
+            pc += (proc.quads[i].opr == OPR_JTAB ? 2 : 1);
+        }
+    }
+
+    // Encode instructions
+    for (int i = 0; i < proc.quads.size(); ++i) {
+        const Quad& q = proc.quads[i];
+
+        if (q.opr == OPR_LABEL) {
+            continue;
+        }
+
+        ImageInstr instr;
+        instr.reserved = 0;
+        instr.arg = 0;
+
+        if (q.operand.kind == OPERAND_SYMBOL && (q.opr == OPR_PUSH || q.opr == OPR_POP)) {
+            const QuadSymbol& sym = proc.symbols[q.operand.symbol];
+
+            if (sym.global) {
+                auto it = globalIds.find(sym.name);
+
+                if (it == globalIds.end()) {
+                    ImageSymbol s;
+                    s.name = addString(sym.name);
+                    globals.push_back(s);
+                    it = globalIds.insert({sym.name, (int) globals.size() - 1}).first;
+                }
+
+                instr.opcode = (q.opr == OPR_PUSH ? IMG_PUSH_GLOBAL : IMG_POP_GLOBAL);
+                instr.arg = it->second;
+            } else {
+                auto it = localIds.find(sym.name);
+
+                if (it == localIds.end()) {
+                    if (&dst != &initCode) {
+                        ImageSymbol s;
+                        s.name = addString(sym.name);
+                        locals.push_back(s);
+                    }
+
+                    it = localIds.insert({sym.name, (int) localIds.size()}).first;
+                }
+
+                instr.opcode = (q.opr == OPR_PUSH ? IMG_PUSH_LOCAL : IMG_POP_LOCAL);
+                instr.arg = it->second;
+            }
+        }
+        else if (q.operand.kind == OPERAND_VALUE) {
+            instr.opcode = IMG_PUSH_IMM;
+            instr.value = q.operand.value;
+        }
+        else if (q.opr == OPR_CALL) {
+            auto it = procIds.find(proc.symbols[q.operand.symbol].name);
+
+            if (it == procIds.end()) {
+                fprintf(stderr, "error: call to undefined procedure '%s' in binary image!\n",
+                        proc.symbols[q.operand.symbol].name.c_str());
+                failed = true;
+                continue;
+            }
+
+            instr.opcode = IMG_CALL;
+            instr.arg = it->second;
+        }
+        else {
+            int opcode = encode(q);
+
+            if (opcode < 0) {
+                fprintf(stderr, "error: cannot encode instruction '%s' in binary image!\n",
+                        (q.opr == OPR_CONV ? Utils::dtypeConvQuad(q.type, q.operand.type) : Utils::oprToQuad(q.opr, q.type)).c_str());
+                failed = true;
+                continue;
+            }
+
+            instr.opcode = (uint16_t) opcode;
+
+            if (q.opr == OPR_JTAB) {
+                // Count the entries, then store the default entry right after the jump
+                int cnt = 0;
+
+                while (i + 1 + cnt < proc.quads.size() && proc.quads[i + 1 + cnt].opr == OPR_CASE) {
+                    cnt++;
+                }
+
+                instr.arg = cnt;
+                dst.push_back(instr);
+
+                instr.opcode = IMG_CASE;
+                instr.arg = labels[q.operand.label];
+            }
+            else if (q.operand.kind == OPERAND_LABEL) {
+                instr.arg = labels[q.operand.label];
+            }
+        }
+
+        dst.push_back(instr);
+    }
+}
+
+int QuadBinaryWriter::encode(const Quad& q) {
+    int t = typeIndex(q.type);
+    int base;
+
+    switch (q.opr) {
+        case OPR_JMP:
+            return IMG_JMP;
+        case OPR_RET:
+            return IMG_RET;
+        case OPR_POP:
+            return IMG_POP;
+        case OPR_DUP:
+            return IMG_DUP;
+        case OPR_JTAB:
+            return IMG_JTAB;
+        case OPR_CASE:
+            return IMG_CASE;
+        case OPR_CONV:
+            if (t < 0 || typeIndex(q.operand.type) < 0) {
+                return -1;
+            }
+            return IMG_CONV + t * 4 + typeIndex(q.operand.type);
+        case OPR_JZ:
+            base = IMG_JZ;
+            break;
+        case OPR_JNZ:
+            base = IMG_JNZ;
+            break;
+        case OPR_JGT:
+            base = IMG_JGT;
+            break;
+        case OPR_JGE:
+            base = IMG_JGE;
+            break;
+        case OPR_JLT:
+            base = IMG_JLT;
+            break;
+        case OPR_JLE:
+            base = IMG_JLE;
+            break;
+        case OPR_JEQ:
+            base = IMG_JEQ;
+            break;
+        case OPR_JNE:
+            base = IMG_JNE;
+            break;
+        case OPR_ADD:
+            base = IMG_ADD;
+            break;
+        case OPR_SUB:
+            base = IMG_SUB;
+            break;
+        case OPR_MUL:
+            base = IMG_MUL;
+            break;
+        case OPR_DIV:
+            base = IMG_DIV;
+            break;
+        case OPR_MOD:
+            base = IMG_MOD;
+            break;
+        case OPR_AND:
+        case OPR_LOGICAL_AND:
+            base = IMG_AND;
+            break;
+        case OPR_OR:
+        case OPR_LOGICAL_OR:
+            base = IMG_OR;
+            break;
+        case OPR_XOR:
+            base = IMG_XOR;
+            break;
+        case OPR_SHL:
+            base = IMG_SHL;
+            break;
+        case OPR_SHR:
+            base = IMG_SHR;
+            break;
+        case OPR_GREATER:
+            base = IMG_GT;
+            break;
+        case OPR_GREATER_EQUAL:
+            base = IMG_GTE;
+            break;
+        case OPR_LESS:
+            base = IMG_LT;
+            break;
+        case OPR_LESS_EQUAL:
+            base = IMG_LTE;
+            break;
+        case OPR_EQUAL:
+            base = IMG_EQU;
+            break;
+        case OPR_NOT_EQUAL:
+            base = IMG_NEQ;
+            break;
+        case OPR_NOT:
+        case OPR_LOGICAL_NOT:
+            base = IMG_NOT;
+            break;
+        case OPR_U_MINUS:
+            base = IMG_NEG;
+            break;
+        case OPR_PRE_INC:
+        case OPR_SUF_INC:
+            base = IMG_INC;
+            break;
+        case OPR_PRE_DEC:
+        case OPR_SUF_DEC:
+            base = IMG_DEC;
+            break;
+        default:
+            return -1;
+    }
+
+    return (t < 0 ? -1 : base + t);
+}
+
+ImageInstr QuadBinaryWriter::makeRet() {
+    ImageInstr instr;
+    instr.opcode = IMG_RET;
+    instr.reserved = 0;
+    instr.arg = 0;
+    return instr;
+}
+
+uint32_t QuadBinaryWriter::addString(const string& str) {
+    uint32_t offset = (uint32_t) strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+}
+
+// =====================================================================================================
+// Image Loader
+// ============
+
+QuadImage::~QuadImage() {
+    release();
+}
+
+bool QuadImage::open(const string& filename) {
+    release();
+
+#ifdef _WIN32
+    ifstream fin(filename, ios::binary);
+
+    if (!fin.is_open()) {
+        return false;
+    }
+
+    storage.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+    data = storage.data();
+    size = storage.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+
+    data = (const char*) ptr;
+    size = st.st_size;
+    mapped = true;
+#endif
+
+    return validate();
+}
+
+bool QuadImage::load(vector<char>& bytes) {
+    release();
+
+    storage.swap(bytes);
+    data = storage.data();
+    size = storage.size();
+
+    return validate();
+}
+
+bool QuadImage::isImage(const char* bytes, size_t len) {
+    return len >= 4 && memcmp(bytes, IMAGE_MAGIC, 4) == 0;
+}
+
+bool QuadImage::validate() {
+    if (size < sizeof(ImageHeader) || !isImage(data, size)) {
+        return false;
+    }
+
+    header = (const ImageHeader*) data;
+
+    if (header->version != IMAGE_VERSION ||
+        header->procsOffset + (uint64_t) header->procCount * sizeof(ImageProc) > size ||
+        header->symbolsOffset + (uint64_t) header->symbolCount * sizeof(ImageSymbol) > size ||
+        header->codeOffset + (uint64_t) header->codeCount * sizeof(ImageInstr) > size ||
+        header->stringsOffset + (uint64_t) header->stringsSize > size ||
+        header->globalCount > header->symbolCount ||
+        header->procCount == 0 || header->mainProc >= (int32_t) header->procCount) {
+        return false;
+    }
+
+    procs = (const ImageProc*) (data + header->procsOffset);
+    symbols = (const ImageSymbol*) (data + header->symbolsOffset);
+    code = (const ImageInstr*) (data + header->codeOffset);
+    strings = data + header->stringsOffset;
+
+    // Check that the strings are null-terminated
+    if (header->stringsSize > 0 && strings[header->stringsSize - 1] != '\0') {
+        return false;
+    }
+
+    // Check the operands of the instructions, so that they can be executed without any bound checks
+    for (uint32_t i = 0; i < header->procCount; ++i) {
+        const ImageProc& p = procs[i];
+
+        if ((uint64_t) p.codeStart + p.codeSize > header->codeCount || p.codeSize == 0 ||
+            (uint64_t) p.symbolStart + p.frameSize > header->symbolCount ||
+            p.name >= header->stringsSize) {
+            return false;
+        }
+
+        if (code[p.codeStart + p.codeSize - 1].opcode != IMG_RET) {
+            return false;
+        }
+
+        for (uint32_t j = p.codeStart; j < p.codeStart + p.codeSize; ++j) {
+            const ImageInstr& instr = code[j];
+
+            switch (instr.opcode) {
+                case IMG_PUSH_LOCAL:
+                case IMG_POP_LOCAL:
+                    if (instr.arg < 0 || instr.arg >= (int32_t) p.frameSize) return false;
+                    break;
+                case IMG_PUSH_GLOBAL:
+                case IMG_POP_GLOBAL:
+                    if (instr.arg < 0 || instr.arg >= (int32_t) header->globalCount) return false;
+                    break;
+                case IMG_CALL:
+                    if (instr.arg <= 0 || instr.arg >= (int32_t) header->procCount) return false;
+                    break;
+                case IMG_JTAB:
+                    if (instr.arg < 0 || j + 1 + (uint64_t) instr.arg >= p.codeStart + p.codeSize) return false;
+
+                    for (uint32_t k = j + 1; k <= j + 1 + instr.arg; ++k) {
+                        if (code[k].opcode != IMG_CASE) return false;
+                    }
+                    break;
+                case IMG_JMP:
+                case IMG_CASE:
+                case IMG_JZ: case IMG_JZ + 1: case IMG_JZ + 2: case IMG_JZ + 3:
+                case IMG_JNZ: case IMG_JNZ + 1: case IMG_JNZ + 2: case IMG_JNZ + 3:
+                    if (instr.arg < 0 || instr.arg >= (int32_t) p.codeSize) return false;
+                    break;
+                default:
+                    if (instr.opcode >= IMG_OPCODE_COUNT) return false;
+
+                    // Compare-and-branch instructions
+                    if (instr.opcode >= IMG_JGT && (instr.arg < 0 || instr.arg >= (int32_t) p.codeSize)) return false;
+                    break;
+            }
+        }
+    }
+
+    return validateStack();
+}
+
+bool QuadImage::validateStack() {
+    /**
+     * Struct holding a call instruction reached by the stack depth analysis.
+     */
+    struct CallSite {
+        uint32_t proc;              // The calling procedure
+        uint32_t pc;                // The offset of the call instruction in its procedure
+        int depth;                  // The stack depth at the call instruction
+    };
+
+    const int UNKNOWN = INT_MIN;
+    uint32_t n = header->procCount;
+
+    // The stack depths are relative to the entry of their procedure, and negative below it (e.g. when popping the arguments)
+    vector<vector<int>> depths(n);
+    vector<int> retDepths(n, UNKNOWN);          // The stack depth at the return instructions of each procedure
+    vector<int64_t> lowDepths(n, 0);            // The lowest stack depth reached by each procedure
+    vector<vector<CallSite>> callSites(n);      // The reached call instructions of each procedure
+    vector<pair<uint32_t, uint32_t>> work;
+
+    // Schedules the given instruction at the given stack depth, failing if it was already reached at another one
+    auto reach = [&](uint32_t proc, uint32_t pc, int depth) {
+        int& d = depths[proc][pc];
+
+        if (d == UNKNOWN) {
+            d = depth;
+            work.push_back(make_pair(proc, pc));
+            return true;
+        }
+
+        return d == depth;
+    };
+
+    for (uint32_t i = 0; i < n; ++i) {
+        depths[i].assign(procs[i].codeSize, UNKNOWN);
+        reach(i, 0, 0);
+    }
+
+    // Follow the control flow of all procedures at once, so that the instructions following a call
+    // are only reached once the stack depth at the return instructions of the callee is known.
+    // A callee that never returns leaves them unreached, as they are never executed.
+    while (!work.empty()) {
+        uint32_t proc = work.back().first;
+        uint32_t pc = work.back().second;
+        work.pop_back();
+
+        const ImageInstr* base = code + procs[proc].codeStart;
+        const ImageInstr& instr = base[pc];
+        int depth = depths[proc][pc];
+        int pops, pushes;
+
+        stackEffect(instr.opcode, pops, pushes);
+        lowDepths[proc] = min<int64_t>(lowDepths[proc], depth - pops);
+        depth += pushes - pops;
+
+        switch (instr.opcode) {
+            case IMG_RET:
+                if (retDepths[proc] == UNKNOWN) {
+                    retDepths[proc] = depth;
+
+                    for (const CallSite& c : callSites[proc]) {
+                        if (!reach(c.proc, c.pc + 1, c.depth + depth)) return false;
+                    }
+                } else if (retDepths[proc] != depth) {
+                    return false;
+                }
+                break;
+            case IMG_CALL:
+                callSites[instr.arg].push_back({ proc, pc, depth });
+
+                if (retDepths[instr.arg] != UNKNOWN && !reach(proc, pc + 1, depth + retDepths[instr.arg])) return false;
+                break;
+            case IMG_JMP:
+                if (!reach(proc, instr.arg, depth)) return false;
+                break;
+            case IMG_JTAB:
+                for (uint32_t k = pc + 1; k <= pc + 1 + instr.arg; ++k) {
+                    if (!reach(proc, base[k].arg, depth)) return false;
+                }
+                break;
+            case IMG_CASE:
+                // Jump table entries are never executed
+                return false;
+            default:
+                // Conditional jumps and compare-and-branch instructions
+                if (((instr.opcode >= IMG_JZ && instr.opcode < IMG_ADD) || instr.opcode >= IMG_JGT) && !reach(proc, instr.arg, depth)) return false;
+                if (!reach(proc, pc + 1, depth)) return false;
+                break;
+        }
+    }
+
+    // A procedure also reaches the lowest stack depths of its callees, relative to the depth at the call.
+    // Propagate them over the calls until they settle, which takes at most as many rounds as there are procedures,
+    // unless a recursion pops more values than it pushes on every call
+    bool changed = true;
+
+    for (uint32_t round = 0; changed; ++round) {
+        if (round > n) {
+            return false;
+        }
+
+        changed = false;
+
+        for (uint32_t i = 0; i < n; ++i) {
+            for (const CallSite& c : callSites[i]) {
+                if (c.depth + lowDepths[i] < lowDepths[c.proc]) {
+                    lowDepths[c.proc] = c.depth + lowDepths[i];
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // The entry procedures run on an empty stack, so they must never reach below it
+    return lowDepths[0] >= 0 && (header->mainProc < 0 || lowDepths[header->mainProc] >= 0);
+}
+
+void QuadImage::release() {
+#ifndef _WIN32
+    if (mapped) {
+        munmap((void*) data, size);
+    }
+#endif
+
+    storage.clear();
+    data = NULL;
+    size = 0;
+    mapped = false;
+    header = NULL;
+    procs = NULL;
+    symbols = NULL;
+    code = NULL;
+    strings = NULL;
+}
\ No newline at end of file
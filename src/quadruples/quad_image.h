@@ -0,0 +1,264 @@
+#ifndef __QUAD_IMAGE_H_
+#define __QUAD_IMAGE_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "quadruple.h"
+#include "quad_writer.h"
+
+using namespace std;
+
+
+//
+// Binary image definitions
+//
+#define IMAGE_MAGIC         "MPPQ"
+#define IMAGE_VERSION       5
+#define IMAGE_ALIGNMENT     8
+
+/**
+ * Enum holding the instruction set of the binary quadruples image.
+ *
+ * Typed instructions take 4 consecutive opcodes, one for each primitive
+ * data type in data type order (bool, char, int, float).
+ * Conversions take 16 consecutive opcodes, indexed by (from * 4 + to).
+ *
+ * Note that the opcodes are part of the binary format.
+ * DON'T CHANGE ENUM ORDER, only append to it and increment IMAGE_VERSION.
+ */
+enum ImageOpcode {
+    IMG_PUSH_IMM = 0,               // PUSH 5, push an immediate value
+    IMG_PUSH_LOCAL,                 // PUSH x, push a local variable of the current frame
+    IMG_PUSH_GLOBAL,                // PUSH x, push a global variable
+    IMG_POP_LOCAL,                  // POP x, pop into a local variable of the current frame
+    IMG_POP_GLOBAL,                 // POP x, pop into a global variable
+    IMG_JMP,                        // JMP L1, unconditional jump
+    IMG_CALL,                       // CALL f, call a procedure
+    IMG_RET,                        // RET, return from the current procedure
+    IMG_JZ,                         // Typed
+    IMG_JNZ     = IMG_JZ + 4,       // Typed
+    IMG_ADD     = IMG_JNZ + 4,      // Typed
+    IMG_SUB     = IMG_ADD + 4,      // Typed
+    IMG_MUL     = IMG_SUB + 4,      // Typed
+    IMG_DIV     = IMG_MUL + 4,      // Typed
+    IMG_MOD     = IMG_DIV + 4,      // Typed
+    IMG_AND     = IMG_MOD + 4,      // Typed
+    IMG_OR      = IMG_AND + 4,      // Typed
+    IMG_XOR     = IMG_OR + 4,       // Typed
+    IMG_SHL     = IMG_XOR + 4,      // Typed
+    IMG_SHR     = IMG_SHL + 4,      // Typed
+    IMG_GT      = IMG_SHR + 4,      // Typed
+    IMG_GTE     = IMG_GT + 4,       // Typed
+    IMG_LT      = IMG_GTE + 4,      // Typed
+    IMG_LTE     = IMG_LT + 4,       // Typed
+    IMG_EQU     = IMG_LTE + 4,      // Typed
+    IMG_NEQ     = IMG_EQU + 4,      // Typed
+    IMG_NOT     = IMG_NEQ + 4,      // Typed
+    IMG_NEG     = IMG_NOT + 4,      // Typed
+    IMG_INC     = IMG_NEG + 4,      // Typed
+    IMG_DEC     = IMG_INC + 4,      // Typed
+    IMG_CONV    = IMG_DEC + 4,      // Conversion
+    IMG_POP     = IMG_CONV + 16,    // POP, pop and discard the top of the stack
+    IMG_DUP,                        // DUP, push a copy of the top of the stack
+    IMG_JTAB,                       // JTAB n, jump table of n entries, followed by the default entry then the n entries
+    IMG_CASE,                       // CASE L1, jump table entry, never executed
+    IMG_JGT,                        // Typed
+    IMG_JGE     = IMG_JGT + 4,      // Typed
+    IMG_JLT     = IMG_JGE + 4,      // Typed
+    IMG_JLE     = IMG_JLT + 4,      // Typed
+    IMG_JEQ     = IMG_JLE + 4,      // Typed
+    IMG_JNE     = IMG_JEQ + 4,      // Typed
+    IMG_OPCODE_COUNT = IMG_JNE + 4
+};
+
+/**
+ * Struct holding the header of the binary quadruples image.
+ *
+ * All sections are arrays of fixed-width records located at the given offsets
+ * from the beginning of the image, and aligned to IMAGE_ALIGNMENT bytes.
+ * All integers are stored in the native byte order.
+ */
+struct ImageHeader {
+    char magic[4];                  // IMAGE_MAGIC
+    uint32_t version;               // IMAGE_VERSION
+    uint32_t procCount;             // Number of procedures, the first one is the global initialization code
+    uint32_t symbolCount;           // Number of symbols, the first globalCount ones are the global variables
+    uint32_t globalCount;           // Number of global variables
+    uint32_t codeCount;             // Number of instructions
+    uint32_t stringsSize;           // Size of the string table in bytes
+    uint32_t procsOffset;           // Offset of the procedures index
+    uint32_t symbolsOffset;         // Offset of the symbol table
+    uint32_t codeOffset;            // Offset of the instruction stream
+    uint32_t stringsOffset;         // Offset of the string table
+    int32_t mainProc;               // Index of the main procedure, or -1 if not available
+};
+
+/**
+ * Struct holding an entry of the procedures index of the binary quadruples image.
+ */
+struct ImageProc {
+    uint32_t name;                  // Offset of the name in the string table
+    uint32_t codeStart;             // Index of the first instruction of the procedure
+    uint32_t codeSize;              // Number of instructions of the procedure
+    uint32_t symbolStart;           // Index of the first local variable in the symbol table
+    uint32_t frameSize;             // Number of local variables of the procedure
+};
+
+/**
+ * Struct holding an entry of the symbol table of the binary quadruples image.
+ */
+struct ImageSymbol {
+    uint32_t name;                  // Offset of the name in the string table
+};
+
+/**
+ * Struct holding a single fixed-width instruction of the binary quadruples image.
+ *
+ * Every procedure is terminated by a return instruction.
+ * Jump tables are stored in place, as jump table entries following their jump instruction.
+ * Jump targets are instruction offsets relative to the beginning of the procedure,
+ * local variables are frame slots, global variables are global slots,
+ * call targets are procedure indices, and immediate values are stored in place.
+ */
+struct ImageInstr {
+    uint16_t opcode;                // ImageOpcode
+    uint16_t reserved;
+
+    union {
+        int32_t arg;                // Slot, jump target or procedure index
+        Value value;                // Immediate value
+    };
+};
+
+/**
+ * Binary quadruples image writer.
+ *
+ * Translates each procedure as soon as it is written,
+ * and writes the complete image into the output stream when finished.
+ */
+class QuadBinaryWriter : public QuadWriter {
+private:
+    ostream& out;
+
+    vector<ImageProc> procs;
+    vector<ImageInstr> code;
+    vector<ImageInstr> initCode;
+    vector<ImageSymbol> globals;
+    vector<ImageSymbol> locals;
+    string strings;
+
+    unordered_map<string, int> procIds;
+    unordered_map<string, int> globalIds;
+    unordered_map<string, int> initLocalIds;
+
+    bool failed = false;
+
+public:
+
+    /**
+     * Constructs a new binary image writer.
+     *
+     * @param out the binary output stream to write into.
+     */
+    QuadBinaryWriter(ostream& out);
+
+    virtual void write(const QuadProc& proc);
+
+    virtual void finish();
+
+    /**
+     * Checks whether all instructions were encoded successfully or not.
+     *
+     * @return {@code true} if an instruction could not be encoded; {@code false} otherwise.
+     */
+    bool hasFailed() {
+        return failed;
+    }
+
+private:
+
+    void translate(const QuadProc& proc, vector<ImageInstr>& dst, unordered_map<string, int>& localIds);
+
+    int encode(const Quad& q);
+
+    ImageInstr makeRet();
+
+    uint32_t addString(const string& str);
+};
+
+/**
+ * Binary quadruples image loader.
+ *
+ * Maps the image file into memory and exposes its sections in place, without any parsing or copying.
+ */
+class QuadImage {
+private:
+    const char* data = NULL;
+    size_t size = 0;
+    bool mapped = false;
+    vector<char> storage;
+
+public:
+    const ImageHeader* header = NULL;
+    const ImageProc* procs = NULL;
+    const ImageSymbol* symbols = NULL;
+    const ImageInstr* code = NULL;
+    const char* strings = NULL;
+
+    QuadImage() {}
+
+    ~QuadImage();
+
+    /**
+     * Maps the given image file into memory.
+     *
+     * @param filename the filename of the image to load.
+     *
+     * @return {@code true} if the image was loaded successfully; {@code false} otherwise.
+     */
+    bool open(const string& filename);
+
+    /**
+     * Loads an image already built in memory, taking the ownership of its bytes.
+     *
+     * @param bytes the bytes of the image.
+     *
+     * @return {@code true} if the image was loaded successfully; {@code false} otherwise.
+     */
+    bool load(vector<char>& bytes);
+
+    /**
+     * Returns the string at the given offset in the string table.
+     *
+     * @param offset the offset of the string.
+     *
+     * @return a pointer to the null-terminated string.
+     */
+    const char* getString(uint32_t offset) const {
+        return strings + offset;
+    }
+
+    /**
+     * Checks whether the given bytes start with a binary quadruples image header or not.
+     *
+     * @param bytes the bytes to check.
+     * @param len   the number of the given bytes.
+     *
+     * @return {@code true} if the bytes start with the image magic; {@code false} otherwise.
+     */
+    static bool isImage(const char* bytes, size_t len);
+
+private:
+
+    bool validate();
+
+    bool validateStack();
+
+    void release();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "quad_optimizer.h"
+
+
+/**
+ * Checks whether the given instruction is a compare-and-branch instruction (e.g. {@code JLT}).
+ */
+static bool isCompareJump(const Quad& q) {
+    return q.opr >= OPR_JGT && q.opr <= OPR_JNE;
+}
+
+/**
+ * Checks whether the given instruction is a jump (e.g. {@code JMP}, {@code JZ}, {@code JLT}).
+ */
+static bool isJump(const Quad& q) {
+    return q.opr == OPR_JMP || q.opr == OPR_JZ || q.opr == OPR_JNZ || isCompareJump(q);
+}
+
+/**
+ * Checks whether the given instruction may transfer the control to a label,
+ * including jump tables and their entries.
+ */
+static bool hasTarget(const Quad& q) {
+    return isJump(q) || q.opr == OPR_JTAB || q.opr == OPR_CASE;
+}
+
+/**
+ * Checks whether the given instruction ends a basic block.
+ */
+static bool isBlockEnd(const Quad& q) {
+    return hasTarget(q) || q.opr == OPR_RET;
+}
+
+/**
+ * Checks whether the control may flow from the given instruction into the next one.
+ */
+static bool fallsThrough(const Quad& q) {
+    return q.opr != OPR_JMP && q.opr != OPR_RET && q.opr != OPR_JTAB && q.opr != OPR_CASE;
+}
+
+/**
+ * Removes the marked instructions from the given procedure.
+ *
+ * @return the number of removed instructions, not counting label definitions.
+ */
+static int removeMarked(QuadProc& proc, const vector<bool>& marked) {
+    int cnt = 0, j = 0;
+
+    for (int i = 0; i < proc.quads.size(); ++i) {
+        if (!marked[i]) {
+            proc.quads[j++] = proc.quads[i];
+        }
+        else if (proc.quads[i].opr != OPR_LABEL) {
+            cnt++;
+        }
+    }
+
+    proc.quads.resize(j);
+    return cnt;
+}
+
+/**
+ * Returns the number of instructions of the given procedure, not counting label definitions.
+ */
+static int countInstructions(const QuadProc& proc) {
+    int cnt = 0;
+
+    for (int i = 0; i < proc.quads.size(); ++i) {
+        cnt += (proc.quads[i].opr != OPR_LABEL);
+    }
+
+    return cnt;
+}
+
+// =====================================================================================================
+// Peephole Rules
+// ==============
+
+/**
+ * Checks whether the two given instructions operate on the same symbol with the same data type.
+ */
+static bool sameSymbol(const Quad& a, const Quad& b) {
+    return a.operand.kind == OPERAND_SYMBOL && b.operand.kind == OPERAND_SYMBOL &&
+           a.operand.symbol == b.operand.symbol && a.type == b.type;
+}
+
+/**
+ * Checks whether the given instruction is a conditional jump.
+ */
+static bool isCondJump(const Quad& q) {
+    return q.opr == OPR_JZ || q.opr == OPR_JNZ;
+}
+
+/**
+ * Checks whether converting from t1 into t2 preserves all the values of t1.
+ */
+static bool isLosslessConv(DataType t1, DataType t2) {
+    return t1 < t2 && !(t1 == DTYPE_INT && t2 == DTYPE_FLOAT);
+}
+
+/**
+ * POP_T x; PUSH_T x  =>  DUP_T; POP_T x
+ */
+static bool rewriteStoreLoad(const Quad* w, vector<Quad>& repl) {
+    if (w[0].opr != OPR_POP || w[1].opr != OPR_PUSH || !sameSymbol(w[0], w[1])) {
+        return false;
+    }
+
+    repl.push_back(Quad(w[0].loc, OPR_DUP, w[0].type));
+    repl.push_back(w[0]);
+    return true;
+}
+
+/**
+ * PUSH_T x; POP_T x  =>  (nothing)
+ */
+static bool rewriteLoadStore(const Quad* w, vector<Quad>& repl) {
+    return w[0].opr == OPR_PUSH && w[1].opr == OPR_POP && sameSymbol(w[0], w[1]);
+}
+
+/**
+ * PUSH_T a; POP_T  =>  (nothing)
+ * DUP_T; POP_T     =>  (nothing)
+ */
+static bool rewritePushDiscard(const Quad* w, vector<Quad>& repl) {
+    return (w[0].opr == OPR_PUSH || w[0].opr == OPR_DUP) &&
+           w[1].opr == OPR_POP && w[1].operand.kind == OPERAND_NONE;
+}
+
+/**
+ * A_TO_B; B_TO_A  =>  (nothing), if no value of A is lost when converted into B
+ */
+static bool rewriteConvCancel(const Quad* w, vector<Quad>& repl) {
+    return w[0].opr == OPR_CONV && w[1].opr == OPR_CONV &&
+           w[0].operand.type == w[1].type && w[1].operand.type == w[0].type &&
+           isLosslessConv(w[0].type, w[0].operand.type);
+}
+
+/**
+ * A_TO_B; B_TO_C  =>  A_TO_C, if no value of A is lost when converted into B
+ */
+static bool rewriteConvChain(const Quad* w, vector<Quad>& repl) {
+    if (w[0].opr != OPR_CONV || w[1].opr != OPR_CONV || w[0].operand.type != w[1].type ||
+        w[1].operand.type == w[0].type || !isLosslessConv(w[0].type, w[0].operand.type)) {
+        return false;
+    }
+
+    repl.push_back(w[1]);
+    repl.back().type = w[0].type;
+    return true;
+}
+
+/**
+ * T_TO_BOOL; JZ_BOOL L  =>  JZ_T L
+ */
+static bool rewriteConvBranch(const Quad* w, vector<Quad>& repl) {
+    if (w[0].opr != OPR_CONV || w[0].operand.type != DTYPE_BOOL || !isCondJump(w[1]) || w[1].type != DTYPE_BOOL) {
+        return false;
+    }
+
+    repl.push_back(w[1]);
+    repl.back().type = w[0].type;
+    return true;
+}
+
+/**
+ * NOT_BOOL; JZ_BOOL L  =>  JNZ_BOOL L
+ */
+static bool rewriteNotBranch(const Quad* w, vector<Quad>& repl) {
+    if ((w[0].opr != OPR_NOT && w[0].opr != OPR_LOGICAL_NOT) || w[0].type != DTYPE_BOOL ||
+        !isCondJump(w[1]) || w[1].type != DTYPE_BOOL) {
+        return false;
+    }
+
+    repl.push_back(w[1]);
+    repl.back().opr = (w[1].opr == OPR_JZ ? OPR_JNZ : OPR_JZ);
+    return true;
+}
+
+/**
+ * PUSH_T c; JZ_T L  =>  JMP L, or (nothing), depending on the constant
+ */
+static bool rewriteConstBranch(const Quad* w, vector<Quad>& repl) {
+    if (w[0].opr != OPR_PUSH || w[0].operand.kind != OPERAND_VALUE || !isCondJump(w[1]) || w[0].type != w[1].type) {
+        return false;
+    }
+
+    bool cond = Utils::convertValue(w[0].operand.value, w[0].type, DTYPE_BOOL).boolVal;
+
+    if (cond == (w[1].opr == OPR_JNZ)) {
+        repl.push_back(w[1]);
+        repl.back().opr = OPR_JMP;
+        repl.back().type = DTYPE_UNKNOWN;
+    }
+
+    return true;
+}
+
+/**
+ * JMP L; L:  =>  L:
+ * JZ_T L; L:  =>  POP_T; L:
+ * JLT_T L; L:  =>  POP_T; POP_T; L:
+ */
+static bool rewriteJumpNext(const Quad* w, vector<Quad>& repl) {
+    if (!isJump(w[0]) || w[1].opr != OPR_LABEL || w[0].operand.label != w[1].operand.label) {
+        return false;
+    }
+
+    if (isCondJump(w[0]) || isCompareJump(w[0])) {
+        repl.push_back(Quad(w[0].loc, OPR_POP, w[0].type));
+    }
+    if (isCompareJump(w[0])) {
+        repl.push_back(Quad(w[0].loc, OPR_POP, w[0].type));
+    }
+
+    repl.push_back(w[1]);
+    return true;
+}
+
+/**
+ * The peephole rules, tried in order on each window.
+ */
+static const PeepholeRule peepholeRules[] = {
+    {"store-load",      2,  rewriteStoreLoad},
+    {"load-store",      2,  rewriteLoadStore},
+    {"push-discard",    2,  rewritePushDiscard},
+    {"conv-cancel",     2,  rewriteConvCancel},
+    {"conv-chain",      2,  rewriteConvChain},
+    {"conv-branch",     2,  rewriteConvBranch},
+    {"not-branch",      2,  rewriteNotBranch},
+    {"const-branch",    2,  rewriteConstBranch},
+    {"jump-next",       2,  rewriteJumpNext},
+};
+
+// =====================================================================================================
+// Optimizer
+// =========
+
+void QuadOptimizer::write(const QuadProc& proc) {
+    if (level <= 0) {
+        next->write(proc);
+        return;
+    }
+
+    QuadProc opt(proc);
+    int cnt = countInstructions(opt);
+
+    counters["dead code"] += removeUnreachableCode(opt);
+    counters["dead stores"] += removeDeadStores(opt);
+
+    threadJumps(opt);
+    applyPeephole(opt);
+
+    // The store-load rule may leave stores that are no longer read (e.g. the condition of a jump table)
+    counters["dead stores"] += removeDeadStores(opt);
+
+    // Jump threading and constant branches may leave more unreachable code behind
+    counters["dead code"] += removeUnreachableCode(opt);
+
+    compactLabels(opt);
+
+    removedCount += cnt - countInstructions(opt);
+
+    next->write(opt);
+}
+
+void QuadOptimizer::printStats(ostream& out) {
+    for (auto& it : counters) {
+        out << "    " << it.first << ": " << it.second << '\n';
+    }
+
+    out << "optimizer: " << removedCount << " instructions removed" << endl;
+}
+
+vector<BasicBlock> QuadOptimizer::buildBasicBlocks(const QuadProc& proc) {
+    const vector<Quad>& quads = proc.quads;
+    vector<BasicBlock> blocks;
+    unordered_map<int, int> labelBlocks;
+
+    // Split the instructions at labels and after jumps, keeping jump tables in the block of their jump
+    for (int i = 0; i < quads.size(); ++i) {
+        if (i == 0 || quads[i].opr == OPR_LABEL || isBlockEnd(quads[i - 1]) && quads[i].opr != OPR_CASE) {
+            if (!blocks.empty()) {
+                blocks.back().end = i;
+            }
+
+            blocks.push_back(BasicBlock());
+            blocks.back().begin = i;
+        }
+
+        if (quads[i].opr == OPR_LABEL) {
+            labelBlocks[quads[i].operand.label] = (int) blocks.size() - 1;
+        }
+    }
+
+    if (!blocks.empty()) {
+        blocks.back().end = (int) quads.size();
+    }
+
+    // Link the blocks
+    for (int b = 0; b < blocks.size(); ++b) {
+        for (int i = blocks[b].begin; i < blocks[b].end; ++i) {
+            if (hasTarget(quads[i])) {
+                auto it = labelBlocks.find(quads[i].operand.label);
+
+                if (it != labelBlocks.end()) {
+                    blocks[b].successors.push_back(it->second);
+                }
+            }
+        }
+
+        if (fallsThrough(quads[blocks[b].end - 1])) {
+            if (b + 1 < blocks.size()) {
+                blocks[b].successors.push_back(b + 1);
+            }
+        }
+    }
+
+    return blocks;
+}
+
+int QuadOptimizer::removeUnreachableCode(QuadProc& proc) {
+    vector<BasicBlock> blocks = buildBasicBlocks(proc);
+
+    if (blocks.empty()) {
+        return 0;
+    }
+
+    // Traverse the blocks reachable from the entry block
+    vector<bool> reachable(blocks.size(), false);
+    vector<int> stk = {0};
+    reachable[0] = true;
+
+    while (!stk.empty()) {
+        int b = stk.back();
+        stk.pop_back();
+
+        for (int s : blocks[b].successors) {
+            if (!reachable[s]) {
+                reachable[s] = true;
+                stk.push_back(s);
+            }
+        }
+    }
+
+    vector<bool> marked(proc.quads.size(), false);
+
+    for (int b = 0; b < blocks.size(); ++b) {
+        if (!reachable[b]) {
+            fill(marked.begin() + blocks[b].begin, marked.begin() + blocks[b].end, true);
+        }
+    }
+
+    return removeMarked(proc, marked);
+}
+
+int QuadOptimizer::removeDeadStores(QuadProc& proc) {
+    vector<Quad>& quads = proc.quads;
+
+    // Find the local variables that are never read by the procedure
+    vector<bool> read(proc.symbols.size(), false);
+
+    for (int i = 0; i < quads.size(); ++i) {
+        if (quads[i].opr == OPR_PUSH && quads[i].operand.kind == OPERAND_SYMBOL) {
+            read[quads[i].operand.symbol] = true;
+        }
+    }
+
+    vector<bool> marked(quads.size(), false);
+    int discarded = 0;
+
+    for (int i = 0; i < quads.size(); ++i) {
+        Quad& q = quads[i];
+
+        if (q.opr != OPR_POP || q.operand.kind != OPERAND_SYMBOL ||
+            read[q.operand.symbol] || proc.symbols[q.operand.symbol].global) {
+            continue;
+        }
+
+        // Remove the store together with the value, if it is a plain push or a duplicate,
+        // otherwise discard the computed value to keep its side effects (e.g. function calls)
+        if (i > 0 && (quads[i - 1].opr == OPR_PUSH || quads[i - 1].opr == OPR_DUP) && !marked[i - 1]) {
+            marked[i - 1] = marked[i] = true;
+        } else {
+            q.operand = QuadOperand();
+            discarded++;
+        }
+    }
+
+    return removeMarked(proc, marked) + discarded;
+}
+
+void QuadOptimizer::threadJumps(QuadProc& proc) {
+    vector<Quad>& quads = proc.quads;
+    unordered_map<int, int> targets;
+
+    // Map each label into the first label of its run of consecutive labels,
+    // or into the target of the unconditional jump right after it
+    for (int i = 0; i < quads.size(); ++i) {
+        if (quads[i].opr != OPR_LABEL) {
+            continue;
+        }
+
+        int j = i;
+
+        while (j < quads.size() && quads[j].opr == OPR_LABEL) {
+            targets[quads[j++].operand.label] = quads[i].operand.label;
+        }
+
+        if (j < quads.size() && quads[j].opr == OPR_JMP) {
+            for (int k = i; k < j; ++k) {
+                targets[quads[k].operand.label] = quads[j].operand.label;
+            }
+        }
+
+        i = j - 1;
+    }
+
+    // Redirect the jumps into their final targets, the number of steps is bounded to stop at jump cycles
+    for (int i = 0; i < quads.size(); ++i) {
+        if (!hasTarget(quads[i])) {
+            continue;
+        }
+
+        int label = quads[i].operand.label;
+
+        for (int steps = 0; steps < targets.size(); ++steps) {
+            auto it = targets.find(label);
+
+            if (it == targets.end() || it->second == label) {
+                break;
+            }
+
+            label = it->second;
+        }
+
+        if (label != quads[i].operand.label) {
+            quads[i].operand.label = label;
+            counters["jump threading"]++;
+        }
+    }
+}
+
+void QuadOptimizer::applyPeephole(QuadProc& proc) {
+    const int rulesCount = sizeof(peepholeRules) / sizeof(peepholeRules[0]);
+
+    vector<Quad>& quads = proc.quads;
+    vector<Quad> out, pending, repl;
+    int i = 0;
+
+    out.reserve(quads.size());
+
+    // Slide the window over the instructions as they are moved into the output,
+    // the replacements are moved back again so that they can match with the preceding instructions
+    while (i < quads.size() || !pending.empty()) {
+        if (pending.empty()) {
+            out.push_back(quads[i++]);
+        } else {
+            out.push_back(pending.back());
+            pending.pop_back();
+        }
+
+        for (int r = 0; r < rulesCount; ++r) {
+            const PeepholeRule& rule = peepholeRules[r];
+
+            if (out.size() < rule.size) {
+                continue;
+            }
+
+            repl.clear();
+
+            if (rule.rewrite(&out[out.size() - rule.size], repl)) {
+                counters[string("peephole ") + rule.name]++;
+                out.resize(out.size() - rule.size);
+                pending.insert(pending.end(), repl.rbegin(), repl.rend());
+                break;
+            }
+        }
+    }
+
+    quads.swap(out);
+}
+
+void QuadOptimizer::compactLabels(QuadProc& proc) {
+    vector<Quad>& quads = proc.quads;
+    unordered_map<int, int> labels;
+
+    // Find the referenced labels
+    for (int i = 0; i < quads.size(); ++i) {
+        if (hasTarget(quads[i])) {
+            labels[quads[i].operand.label] = 0;
+        }
+    }
+
+    // Remove the unreferenced labels, and renumber the referenced ones in order,
+    // from one for functions as each has its own namespace of labels
+    vector<bool> marked(quads.size(), false);
+    int functionLabelCounter = 1;
+    int& counter = (proc.name.empty() ? labelCounter : functionLabelCounter);
+
+    for (int i = 0; i < quads.size(); ++i) {
+        if (quads[i].opr != OPR_LABEL) {
+            continue;
+        }
+
+        auto it = labels.find(quads[i].operand.label);
+
+        if (it == labels.end() || it->second != 0) {
+            marked[i] = true;
+        } else {
+            it->second = counter++;
+            quads[i].operand.label = it->second;
+        }
+    }
+
+    removeMarked(proc, marked);
+
+    for (int i = 0; i < quads.size(); ++i) {
+        if (hasTarget(quads[i])) {
+            quads[i].operand.label = labels[quads[i].operand.label];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef __QUAD_OPTIMIZER_H_
+#define __QUAD_OPTIMIZER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "quadruple.h"
+#include "quad_writer.h"
+
+using namespace std;
+
+
+/**
+ * Struct holding a basic block of a procedure, that is a maximal sequence of instructions
+ * entered only at its first instruction and left only at its last one.
+ */
+struct BasicBlock {
+    int begin;                  // Index of the first instruction of the block
+    int end;                    // Index past the last instruction of the block
+    vector<int> successors;     // Indices of the blocks control may flow into after this block
+};
+
+/**
+ * Struct holding a peephole rewrite rule.
+ *
+ * A rule matches a fixed-size window of consecutive instructions,
+ * and rewrites it into a (usually shorter) sequence of instructions.
+ */
+struct PeepholeRule {
+    const char* name;           // The name of the rule, used in the statistics
+    int size;                   // The number of instructions in the matched window
+
+    /**
+     * Tries to rewrite the given window of instructions.
+     *
+     * @param window the first instruction of the window.
+     * @param repl   the list to append the replacement instructions into.
+     *
+     * @return {@code true} if the window is matched and rewritten; {@code false} otherwise.
+     */
+    bool (*rewrite)(const Quad* window, vector<Quad>& repl);
+};
+
+/**
+ * Quadruples optimizer.
+ *
+ * Optimizes each procedure written into it, then forwards it to the next output sink.
+ *
+ * Optimization levels:
+ * - 0: no optimizations.
+ * - 1: dead code and dead store elimination, jump threading, peephole rewrites, and labels compaction.
+ */
+class QuadOptimizer : public QuadWriter {
+private:
+    QuadWriter* next;
+    int level;
+
+    map<string, int> counters;
+    int removedCount = 0;
+    int labelCounter = 1;       // The label counter of the global code
+
+public:
+
+    /**
+     * Constructs a new optimizer.
+     *
+     * @param next  the output sink to write the optimized procedures into.
+     * @param level the optimization level.
+     */
+    QuadOptimizer(QuadWriter* next, int level) : next(next), level(level) {}
+
+    virtual void write(const QuadProc& proc);
+
+    virtual void finish() {
+        next->finish();
+    }
+
+    /**
+     * Returns the statistics of the applied optimizations, mapping each optimization name
+     * to the number of instructions it removed (dead code and dead stores, including the stores
+     * turned into discards of their computed values), or to the number of times it was applied
+     * (jump threading and peephole rules).
+     *
+     * @return the optimizations counters.
+     */
+    const map<string, int>& getCounters() {
+        return counters;
+    }
+
+    /**
+     * Prints the statistics of the applied optimizations into the given stream.
+     *
+     * @param out the output stream to print into.
+     */
+    void printStats(ostream& out);
+
+    /**
+     * Splits the given procedure into basic blocks and links them together.
+     *
+     * @param proc the procedure to split.
+     *
+     * @return the basic blocks of the procedure, in the order of their instructions.
+     */
+    static vector<BasicBlock> buildBasicBlocks(const QuadProc& proc);
+
+private:
+
+    int removeUnreachableCode(QuadProc& proc);
+
+    int removeDeadStores(QuadProc& proc);
+
+    void threadJumps(QuadProc& proc);
+
+    void applyPeephole(QuadProc& proc);
+
+    void compactLabels(QuadProc& proc);
+};
+
+#endif
\ No newline at end of file
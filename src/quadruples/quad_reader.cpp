@@ -0,0 +1,212 @@
+#include <cctype>
+#include <cstdlib>
+
+#include "quad_reader.h"
+
+
+QuadTextReader::QuadTextReader() {
+    // Build reverse lookup tables of the quadruple names
+    for (int t = DTYPE_VOID; t <= DTYPE_ERROR; ++t) {
+        dtypes[Utils::dtypeToQuad((DataType) t)] = (DataType) t;
+    }
+
+    for (int o = OPR_ASSIGN; o <= OPR_LABEL; ++o) {
+        for (int t = DTYPE_VOID; t <= DTYPE_ERROR; ++t) {
+            string name = Utils::oprToQuad((Operator) o, (DataType) t);
+
+            if (name == "#" || oprs.count(name)) {
+                continue;
+            }
+
+            if (o == OPR_JMP || o == OPR_CALL || o == OPR_RET || o == OPR_JTAB || o == OPR_CASE) {
+                oprs[name] = {(Operator) o, DTYPE_UNKNOWN};
+            } else {
+                oprs[name] = {(Operator) o, (DataType) t};
+            }
+        }
+    }
+}
+
+bool QuadTextReader::read(istream& in, vector<QuadProc>& procs) {
+    QuadProc proc;
+    string line;
+
+    lineNum = 0;
+    globals.clear();
+
+    while (getline(in, line)) {
+        lineNum++;
+
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+            line.pop_back();
+        }
+
+        if (line.compare(0, 7, "GLOBAL ") == 0) {
+            globals.insert(line.substr(7));
+        }
+        else if (line.compare(0, 5, "PROC ") == 0) {
+            if (!proc.quads.empty()) {
+                procs.push_back(proc);
+            }
+
+            proc.clear();
+            proc.name = line.substr(5);
+            globals.clear();
+        }
+        else if (line.compare(0, 5, "ENDP ") == 0) {
+            if (proc.name != line.substr(5)) {
+                error = "unexpected '" + line + "'";
+                return false;
+            }
+
+            procs.push_back(proc);
+            proc.clear();
+            globals.clear();
+        }
+        else if (!parseLine(line, proc)) {
+            return false;
+        }
+    }
+
+    if (!proc.name.empty()) {
+        error = "missing 'ENDP " + proc.name + "'";
+        return false;
+    }
+
+    if (!proc.quads.empty()) {
+        procs.push_back(proc);
+    }
+
+    return true;
+}
+
+bool QuadTextReader::parseLine(const string& line, QuadProc& proc) {
+    if (line.empty()) {
+        return true;
+    }
+
+    Location loc = {lineNum, 1, (int) line.size()};
+
+    // Label definition
+    if (line[0] == 'L' && line.back() == ':') {
+        Quad q(loc, OPR_LABEL);
+        q.operand.kind = OPERAND_LABEL;
+        q.operand.label = parseLabel(line);
+        proc.quads.push_back(q);
+        return true;
+    }
+
+    size_t space = line.find(' ');
+    string name = line.substr(0, space);
+    string arg = (space == string::npos ? "" : line.substr(space + 1));
+
+    // Data type conversion
+    size_t conv = name.find("_TO_");
+
+    if (conv != string::npos) {
+        auto from = dtypes.find(name.substr(0, conv));
+        auto to = dtypes.find(name.substr(conv + 4));
+
+        if (from == dtypes.end() || to == dtypes.end()) {
+            error = "unknown conversion '" + name + "'";
+            return false;
+        }
+
+        Quad q(loc, OPR_CONV, from->second);
+        q.operand.kind = OPERAND_TYPE;
+        q.operand.type = to->second;
+        proc.quads.push_back(q);
+        return true;
+    }
+
+    auto it = oprs.find(name);
+
+    if (it == oprs.end()) {
+        error = "unknown instruction '" + name + "'";
+        return false;
+    }
+
+    Quad q(loc, it->second.first, it->second.second);
+
+    if (arg.empty()) {
+        proc.quads.push_back(q);
+        return true;
+    }
+
+    switch (q.opr) {
+        case OPR_JMP:
+        case OPR_JZ:
+        case OPR_JNZ:
+        case OPR_JTAB:
+        case OPR_CASE:
+        case OPR_JGT:
+        case OPR_JGE:
+        case OPR_JLT:
+        case OPR_JLE:
+        case OPR_JEQ:
+        case OPR_JNE:
+            if (arg[0] != 'L') {
+                error = "invalid label '" + arg + "'";
+                return false;
+            }
+
+            q.operand.kind = OPERAND_LABEL;
+            q.operand.label = parseLabel(arg);
+            break;
+        case OPR_CALL:
+            q.operand.kind = OPERAND_SYMBOL;
+            q.operand.symbol = proc.getSlot(interns.intern(arg), interns, true);
+            break;
+        case OPR_PUSH:
+            if (isdigit(arg[0]) || arg[0] == '-' || arg[0] == '+' || arg[0] == '.' || arg[0] == '\'' ||
+                arg == "true" || arg == "false") {
+                q.operand.kind = OPERAND_VALUE;
+
+                if (!parseValue(arg, q.type, q.operand.value)) {
+                    error = "invalid value '" + arg + "'";
+                    return false;
+                }
+                break;
+            }
+        case OPR_POP:
+            q.operand.kind = OPERAND_SYMBOL;
+            q.operand.symbol = proc.getSlot(interns.intern(arg), interns, globals.count(arg) > 0);
+            break;
+        default:
+            error = "unexpected operand '" + arg + "'";
+            return false;
+    }
+
+    proc.quads.push_back(q);
+    return true;
+}
+
+bool QuadTextReader::parseValue(const string& str, DataType type, Value& val) {
+    char* end;
+
+    val.intVal = 0;
+
+    if (type == DTYPE_CHAR && str.size() == 3 && str[0] == '\'' && str[2] == '\'') {
+        val.charVal = str[1];
+        return true;
+    }
+
+    if (type == DTYPE_BOOL && (str == "true" || str == "false")) {
+        val.boolVal = (str == "true");
+        return true;
+    }
+
+    if (type == DTYPE_FLOAT) {
+        val.floatVal = strtof(str.c_str(), &end);
+    } else {
+        val = Utils::intToValue((int) strtol(str.c_str(), &end, 10), type);
+    }
+
+    return *end == '\0';
+}
+
+int QuadTextReader::parseLabel(const string& str) {
+    // Labels of named procedures are prefixed by the name of the procedure (e.g. "Lmain_1")
+    size_t sep = str.rfind('_');
+    return atoi(str.c_str() + (sep == string::npos ? 1 : sep + 1));
+}
\ No newline at end of file
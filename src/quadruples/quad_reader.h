@@ -0,0 +1,68 @@
+#ifndef __QUAD_READER_H_
+#define __QUAD_READER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "quadruple.h"
+
+using namespace std;
+
+
+/**
+ * Quadruples text parser.
+ *
+ * Reads the text produced by {@code QuadTextWriter} back into procedures.
+ * The symbols declared by the {@code GLOBAL} lines of a procedure are global,
+ * and all other symbols are local to the procedure.
+ */
+class QuadTextReader {
+private:
+    unordered_map<string, pair<Operator, DataType>> oprs;
+    unordered_map<string, DataType> dtypes;
+
+    InternTable interns;                // The symbol names read so far
+    unordered_set<string> globals;      // The global variables declared in the current procedure
+
+    string error;
+    int lineNum = 0;
+
+public:
+
+    /**
+     * Constructs a new text parser.
+     */
+    QuadTextReader();
+
+    /**
+     * Parses the given quadruples text stream.
+     *
+     * @param in    the input stream to read from.
+     * @param procs the list to append the parsed procedures into.
+     *
+     * @return {@code true} if the stream was parsed successfully; {@code false} otherwise.
+     */
+    bool read(istream& in, vector<QuadProc>& procs);
+
+    /**
+     * Returns the error message of the last failed parsing.
+     *
+     * @return the error message.
+     */
+    string getError() {
+        return "line " + to_string(lineNum) + ": " + error;
+    }
+
+private:
+
+    bool parseLine(const string& line, QuadProc& proc);
+
+    bool parseValue(const string& str, DataType type, Value& val);
+
+    int parseLabel(const string& str);
+};
+
+#endif
\ No newline at end of file
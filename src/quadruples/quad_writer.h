@@ -0,0 +1,160 @@
+#ifndef __QUAD_WRITER_H_
+#define __QUAD_WRITER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "quadruple.h"
+
+using namespace std;
+
+
+/**
+ * The base class of all output sinks of the generated procedures.
+ */
+class QuadWriter {
+public:
+
+    virtual ~QuadWriter() {}
+
+    /**
+     * Writes the given procedure into this sink.
+     *
+     * @param proc the procedure to write.
+     */
+    virtual void write(const QuadProc& proc) = 0;
+
+    /**
+     * Finalizes the output of this sink after all procedures have been written.
+     */
+    virtual void finish() {}
+};
+
+/**
+ * Output sink buffering the procedures written into it in memory.
+ */
+class QuadProcBuffer : public QuadWriter {
+public:
+    vector<QuadProc> procs;
+
+    virtual void write(const QuadProc& proc) {
+        procs.push_back(proc);
+    }
+};
+
+/**
+ * Quadruples text serializer.
+ *
+ * Writes each instruction on a separate line (e.g. {@code PUSH_INT x@1}),
+ * and wraps named procedures with {@code PROC} and {@code ENDP} lines.
+ * The labels of a named procedure are prefixed by its name (e.g. {@code Lmain_1}).
+ * As the instructions do not tell the scope of their variables, each procedure begins
+ * by a {@code GLOBAL} line for each global variable it references (e.g. {@code GLOBAL x}).
+ */
+class QuadTextWriter : public QuadWriter {
+private:
+    ostream& out;
+
+public:
+
+    /**
+     * Constructs a new text serializer.
+     *
+     * @param out the output stream to write into.
+     */
+    QuadTextWriter(ostream& out) : out(out) {}
+
+    virtual void write(const QuadProc& proc) {
+        if (!proc.name.empty()) {
+            out << "PROC " << proc.name << '\n';
+        }
+
+        writeGlobals(proc);
+
+        for (int i = 0; i < proc.quads.size(); ++i) {
+            writeQuad(proc, proc.quads[i]);
+        }
+
+        if (!proc.name.empty()) {
+            out << "ENDP " << proc.name << '\n';
+        }
+    }
+
+    /**
+     * Writes a {@code GLOBAL} line for each global variable referenced by the given procedure.
+     *
+     * @param proc the procedure to declare the global variables of.
+     */
+    void writeGlobals(const QuadProc& proc) {
+        unordered_set<string> declared;
+
+        for (int i = 0; i < proc.quads.size(); ++i) {
+            const Quad& q = proc.quads[i];
+
+            if (q.operand.kind != OPERAND_SYMBOL || (q.opr != OPR_PUSH && q.opr != OPR_POP)) {
+                continue;
+            }
+
+            const QuadSymbol& sym = proc.symbols[q.operand.symbol];
+
+            if (sym.global && declared.insert(sym.name).second) {
+                out << "GLOBAL " << sym.name << '\n';
+            }
+        }
+    }
+
+    /**
+     * Writes the given instruction as a single line.
+     *
+     * @param proc the procedure of the instruction.
+     * @param q    the instruction to write.
+     */
+    void writeQuad(const QuadProc& proc, const Quad& q) {
+        switch (q.opr) {
+            case OPR_LABEL:
+                writeLabel(proc, q.operand.label);
+                out << ":\n";
+                return;
+            case OPR_CONV:
+                out << Utils::dtypeConvQuad(q.type, q.operand.type) << '\n';
+                return;
+        }
+
+        out << Utils::oprToQuad(q.opr, q.type);
+
+        switch (q.operand.kind) {
+            case OPERAND_SYMBOL:
+                out << ' ' << proc.symbols[q.operand.symbol].name;
+                break;
+            case OPERAND_VALUE:
+                out << ' ' << Utils::valueToQuad(q.operand.value, q.type);
+                break;
+            case OPERAND_LABEL:
+                out << ' ';
+                writeLabel(proc, q.operand.label);
+                break;
+        }
+
+        out << '\n';
+    }
+
+    /**
+     * Writes the name of the given label.
+     *
+     * @param proc  the procedure of the label.
+     * @param label the label to write.
+     */
+    void writeLabel(const QuadProc& proc, int label) {
+        out << 'L';
+
+        if (!proc.name.empty()) {
+            out << proc.name << '_';
+        }
+
+        out << label;
+    }
+};
+
+#endif
\ No newline at end of file
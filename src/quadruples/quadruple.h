@@ -0,0 +1,111 @@
+#ifndef __QUADRUPLE_H_
+#define __QUADRUPLE_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "../utils/consts.h"
+#include "../utils/utils.h"
+
+using namespace std;
+
+
+/**
+ * Struct holding the operand of a quadruple instruction.
+ */
+struct QuadOperand {
+    OperandKind kind;
+
+    union {
+        int symbol;         // Slot of the symbol in the symbol table of the procedure
+        int label;          // Id of the label
+        Value value;        // Immediate value
+        DataType type;      // Target type of a conversion
+    };
+
+    QuadOperand() {
+        this->kind = OPERAND_NONE;
+        this->label = 0;
+    }
+};
+
+/**
+ * Struct holding a single quadruple instruction.
+ *
+ * The opcode of the instruction is the pair of its operator and
+ * its data type (e.g. {@code OPR_ADD} and {@code DTYPE_INT} for {@code ADD_INT}).
+ */
+struct Quad {
+    Operator opr;           // The operator of the instruction
+    DataType type;          // The data type of the instruction, or the source type of a conversion
+    QuadOperand operand;    // The operand of the instruction, if any
+    Location loc;           // The location of the source code that generated this instruction
+
+    Quad() {}
+
+    Quad(const Location& loc, Operator opr, DataType type = DTYPE_UNKNOWN) {
+        this->opr = opr;
+        this->type = type;
+        this->loc = loc;
+    }
+};
+
+/**
+ * Struct holding a symbol referenced by the instructions of a procedure.
+ */
+struct QuadSymbol {
+    string name;            // The alias name of the symbol
+    bool global;            // Whether the symbol is declared in the global scope or not
+
+    QuadSymbol(const string& name, bool global) {
+        this->name = name;
+        this->global = global;
+    }
+};
+
+/**
+ * Struct holding the instructions of a single procedure.
+ *
+ * Code generated outside any function (i.e. global variables initialization)
+ * is held in an unnamed procedure.
+ */
+struct QuadProc {
+    string name;                            // The alias name of the function, empty for global code
+    vector<QuadSymbol> symbols;             // The symbols referenced by this procedure, indexed by slot
+    vector<Quad> quads;                     // The instructions of this procedure
+    unordered_map<InternId, int> slots;     // Map from interned symbol alias name to its slot
+
+    /**
+     * Returns the slot of the given symbol in this procedure,
+     * adding it to the symbol table if not already added.
+     *
+     * @param name    the interned alias name of the symbol.
+     * @param interns the intern table the name is interned into.
+     * @param global  whether the symbol is declared in the global scope or not.
+     *
+     * @return the slot of the symbol.
+     */
+    int getSlot(InternId name, const InternTable& interns, bool global) {
+        auto it = slots.find(name);
+
+        if (it != slots.end()) {
+            return it->second;
+        }
+
+        symbols.push_back(QuadSymbol(interns.str(name), global));
+        return slots[name] = (int) symbols.size() - 1;
+    }
+
+    /**
+     * Clears this procedure to be reused.
+     */
+    void clear() {
+        name.clear();
+        symbols.clear();
+        quads.clear();
+        slots.clear();
+    }
+};
+
+#endif
\ No newline at end of file
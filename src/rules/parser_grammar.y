@@ -3,25 +3,57 @@
 #include <string>
 
 #include "../parse_tree/parse_tree.h"
+#include "../context/compile_context.h"
 
 using namespace std;
 
+// The parser stacks grow on the heap up to the depth limit of the compilation being parsed
+#define YYMAXDEPTH (context->maxParseDepth)
+%}
+
+%code requires {
+class CompileContext;
+}
+
+%code {
 //
-// External functions & variables
+// External functions
 //
-extern int yylex();
-extern Location curLoc;
+extern int yylex(YYSTYPE* lval, void* scanner);
+
+/**
+ * Reads the next token, measuring the time spent in the lexer if the compilation has a time report.
+ * Only the cheap costs are sampled per token (see {@code TimeReport::enter}).
+ */
+static int lexToken(YYSTYPE* lval, void* scanner, CompileContext* context) {
+    if (context->timeReport == NULL) {
+        return yylex(lval, scanner);
+    }
+
+    context->timeReport->enter(PHASE_LEX, false);
+    int token = yylex(lval, scanner);
+    context->timeReport->enter(PHASE_PARSE, false);
+    return token;
+}
+
+#define yylex(lval, scanner) lexToken(lval, scanner, context)
 
 //
 // Functions prototypes
 //
-void yyerror(const char* s);
+void yyerror(void* scanner, CompileContext* context, const char* s);
+}
 
+// =====================================================================================================
+// Parser Options
+// ==============
 //
-// Global variables
-//
-StatementNode* programRoot = NULL;
-%}
+// The parser is pure, all of its state lives on the stack of yyparse
+// and in the compile context of the compilation being parsed.
+
+%define api.pure full
+%lex-param      { void* scanner }
+%parse-param    { void* scanner } { CompileContext* context }
 
 // =====================================================================================================
 // Symbol Types
@@ -125,26 +157,6 @@ StatementNode* programRoot = NULL;
 
 %type <location>            '-' '+' '*' '/' '%' '&' '|' '^' '~' '!' '<' '>' '=' '(' ')' '{' '}' '[' ']' ',' ':' ';'
 
-// =====================================================================================================
-// Destructors
-// ===========
-
-%destructor {
-    if ($$ != NULL) {
-        delete $$;
-        $$ = NULL;
-        // printf(">> DESTRUCTOR\n");
-    } else {
-        // printf(">> DESTRUCTOR NULL\n");
-    }
-}
-<blockNode> <stmtNode> <varDeclNode> <multiVarDeclNode>
-<ifNode> <switchNode> <caseStmtNode>
-<whileNode> <doWhileNode> <forNode>
-<functionNode> <functionCallNode> <returnStmtNode>
-<stmtList> <varList> <exprList>
-<exprNode> <typeNode> <valueNode> <identifierNode>
-
 // =====================================================================================================
 // Precedence & Associativity
 // ==========================
@@ -175,24 +187,32 @@ StatementNode* programRoot = NULL;
 // Rules Section
 // =============
 
-program:            /* epsilon */               { $$ = NULL; programRoot = new BlockNode(); }
-    |               stmt_list                   { $$ = NULL; programRoot = new BlockNode((*$1)[0]->loc, *$1); delete $1; }
+program:            /* epsilon */               { $$ = NULL; context->endProgram(); }
+    |               top_stmt_list               { $$ = NULL; context->endProgram(); }
+    ;
+
+top_stmt_list:      top_stmt
+    |               top_stmt_list top_stmt
+    ;
+
+top_stmt:           stmt                        { context->addStatement($1); }
+    |               stmt_block                  { context->addStatement($1); }
     ;
 
-stmt_list:          stmt                        { $$ = new StmtList(); $$->push_back($1); }
+stmt_list:          stmt                        { $$ = context->arena.make<StmtList>(); $$->push_back($1); }
     |               stmt_list stmt              { $$ = $1; $$->push_back($2); }
-    |               stmt_block                  { $$ = new StmtList(); $$->push_back($1); }
+    |               stmt_block                  { $$ = context->arena.make<StmtList>(); $$->push_back($1); }
     |               stmt_list stmt_block        { $$ = $1; $$->push_back($2); }
     ;
 
-stmt_block:         '{' '}'                     { $$ = new BlockNode($<location>1); }
-    |               '{' stmt_list '}'           { $$ = new BlockNode($<location>1, *$2); delete $2; }
+stmt_block:         '{' '}'                     { $$ = context->arena.make<BlockNode>($<location>1); }
+    |               '{' stmt_list '}'           { $$ = context->arena.make<BlockNode>($<location>1, *$2); }
     ;
 
-stmt:               ';'                         { $$ = new StatementNode($<location>1); }
-    |               BREAK ';'                   { $$ = new BreakStmtNode($<location>1); }
-    |               CONTINUE ';'                { $$ = new ContinueStmtNode($<location>1); }
-    |               expression ';'              { $$ = new ExprContainerNode($1->loc, $1); }
+stmt:               ';'                         { $$ = context->arena.make<StatementNode>($<location>1); }
+    |               BREAK ';'                   { $$ = context->arena.make<BreakStmtNode>($<location>1); }
+    |               CONTINUE ';'                { $$ = context->arena.make<ContinueStmtNode>($<location>1); }
+    |               expression ';'              { $$ = context->arena.make<ExprContainerNode>($1->loc, $1); }
     |               var_decl ';'                { $$ = $1; }
     |               multi_var_decl ';'          { $$ = $1; }
     |               if_stmt                     { $$ = $1; }
@@ -203,9 +223,9 @@ stmt:               ';'                         { $$ = new StatementNode($<locat
     |               for_stmt                    { $$ = $1; }
     |               function                    { $$ = $1; }
     |               return_stmt ';'             { $$ = $1; }
-    |               error ';'                   { $$ = new ErrorNode(curLoc, "invalid syntax"); yyerrok; }
-    |               error ')'                   { $$ = new ErrorNode(curLoc, "invalid syntax"); yyerrok; }
-    |               error '}'                   { $$ = new ErrorNode(curLoc, "invalid syntax"); yyerrok; }
+    |               error ';'                   { $$ = context->arena.make<ErrorNode>(context->curLoc, "invalid syntax"); yyerrok; }
+    |               error ')'                   { $$ = context->arena.make<ErrorNode>(context->curLoc, "invalid syntax"); yyerrok; }
+    |               error '}'                   { $$ = context->arena.make<ErrorNode>(context->curLoc, "invalid syntax"); yyerrok; }
     ;
 
 branch_body:        stmt                        { $$ = $1; }
@@ -217,16 +237,16 @@ branch_body:        stmt                        { $$ = $1; }
 // Declaration Rules
 //
 
-var_decl:           type ident                              { $$ = new VarDeclarationNode($1, $2); }
-    |               CONST type ident                        { $$ = new VarDeclarationNode($2, $3, NULL, true); }
-    |               type ident '=' expression               { $$ = new VarDeclarationNode($1, $2, $4); }
-    |               CONST type ident '=' expression         { $$ = new VarDeclarationNode($2, $3, $5, true); }
+var_decl:           type ident                              { $$ = context->arena.make<VarDeclarationNode>($1, $2); }
+    |               CONST type ident                        { $$ = context->arena.make<VarDeclarationNode>($2, $3, nullptr, true); }
+    |               type ident '=' expression               { $$ = context->arena.make<VarDeclarationNode>($1, $2, $4); }
+    |               CONST type ident '=' expression         { $$ = context->arena.make<VarDeclarationNode>($2, $3, $5, true); }
     ;
 
-multi_var_decl:     var_decl ',' ident                      { $$ = new MultiVarDeclarationNode($1); $$->addVar($3); }
-    |               var_decl ',' ident '=' expression       { $$ = new MultiVarDeclarationNode($1); $$->addVar($3, $5); }
-    |               multi_var_decl ',' ident                { $$ = $1; $$->addVar($3); }
-    |               multi_var_decl ',' ident '=' expression { $$ = $1; $$->addVar($3, $5); }
+multi_var_decl:     var_decl ',' ident                      { $$ = context->arena.make<MultiVarDeclarationNode>($1); $$->addVar(context->arena.make<VarDeclarationNode>($$->type, $3, nullptr, $$->constant)); }
+    |               var_decl ',' ident '=' expression       { $$ = context->arena.make<MultiVarDeclarationNode>($1); $$->addVar(context->arena.make<VarDeclarationNode>($$->type, $3, $5, $$->constant)); }
+    |               multi_var_decl ',' ident                { $$ = $1; $$->addVar(context->arena.make<VarDeclarationNode>($$->type, $3, nullptr, $$->constant)); }
+    |               multi_var_decl ',' ident '=' expression { $$ = $1; $$->addVar(context->arena.make<VarDeclarationNode>($$->type, $3, $5, $$->constant)); }
 
 // ------------------------------------------------------------
 //
@@ -238,41 +258,41 @@ expression:         expr_1
     |               expr_3
     ;
 
-expr_1:             expression '=' expression               { $$ = new AssignOprNode($2, $1, $3); }
-
-    |               expression '+' expression               { $$ = new BinaryOprNode($2, OPR_ADD, $1, $3); }
-    |               expression '-' expression               { $$ = new BinaryOprNode($2, OPR_SUB, $1, $3); }
-    |               expression '*' expression               { $$ = new BinaryOprNode($2, OPR_MUL, $1, $3); }
-    |               expression '/' expression               { $$ = new BinaryOprNode($2, OPR_DIV, $1, $3); }
-    |               expression '%' expression               { $$ = new BinaryOprNode($2, OPR_MOD, $1, $3); }
-    |               expression '&' expression               { $$ = new BinaryOprNode($2, OPR_AND, $1, $3); }
-    |               expression '|' expression               { $$ = new BinaryOprNode($2, OPR_OR, $1, $3); }
-    |               expression '^' expression               { $$ = new BinaryOprNode($2, OPR_XOR, $1, $3); }
-    |               expression SHL expression               { $$ = new BinaryOprNode($2, OPR_SHL, $1, $3); }
-    |               expression SHR expression               { $$ = new BinaryOprNode($2, OPR_SHR, $1, $3); }
-    |               expression LOGICAL_AND expression       { $$ = new BinaryOprNode($2, OPR_LOGICAL_AND, $1, $3); }
-    |               expression LOGICAL_OR expression        { $$ = new BinaryOprNode($2, OPR_LOGICAL_OR, $1, $3); }
-    |               expression '>' expression               { $$ = new BinaryOprNode($2, OPR_GREATER, $1, $3); }
-    |               expression GREATER_EQUAL expression     { $$ = new BinaryOprNode($2, OPR_GREATER_EQUAL, $1, $3); }
-    |               expression '<' expression               { $$ = new BinaryOprNode($2, OPR_LESS, $1, $3); }
-    |               expression LESS_EQUAL expression        { $$ = new BinaryOprNode($2, OPR_LESS_EQUAL, $1, $3); }
-    |               expression EQUAL expression             { $$ = new BinaryOprNode($2, OPR_EQUAL, $1, $3); }
-    |               expression NOT_EQUAL expression         { $$ = new BinaryOprNode($2, OPR_NOT_EQUAL, $1, $3); }
-
-    |               '+' expression %prec U_PLUS             { $$ = new UnaryOprNode($1, OPR_U_PLUS, $2); }
-    |               '-' expression %prec U_MINUM            { $$ = new UnaryOprNode($1, OPR_U_MINUS, $2); }
-    |               '~' expression                          { $$ = new UnaryOprNode($1, OPR_NOT, $2); }
-    |               '!' expression                          { $$ = new UnaryOprNode($1, OPR_LOGICAL_NOT, $2); }
-    ;
-
-expr_2:             INC expr_3 %prec PRE_INC                { $$ = new UnaryOprNode($1, OPR_PRE_INC, $2); }
-    |               DEC expr_3 %prec PRE_DEC                { $$ = new UnaryOprNode($1, OPR_PRE_DEC, $2); }
+expr_1:             expression '=' expression               { $$ = context->arena.make<AssignOprNode>($2, $1, $3); }
+
+    |               expression '+' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_ADD, $1, $3); }
+    |               expression '-' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_SUB, $1, $3); }
+    |               expression '*' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_MUL, $1, $3); }
+    |               expression '/' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_DIV, $1, $3); }
+    |               expression '%' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_MOD, $1, $3); }
+    |               expression '&' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_AND, $1, $3); }
+    |               expression '|' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_OR, $1, $3); }
+    |               expression '^' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_XOR, $1, $3); }
+    |               expression SHL expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_SHL, $1, $3); }
+    |               expression SHR expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_SHR, $1, $3); }
+    |               expression LOGICAL_AND expression       { $$ = context->arena.make<BinaryOprNode>($2, OPR_LOGICAL_AND, $1, $3); }
+    |               expression LOGICAL_OR expression        { $$ = context->arena.make<BinaryOprNode>($2, OPR_LOGICAL_OR, $1, $3); }
+    |               expression '>' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_GREATER, $1, $3); }
+    |               expression GREATER_EQUAL expression     { $$ = context->arena.make<BinaryOprNode>($2, OPR_GREATER_EQUAL, $1, $3); }
+    |               expression '<' expression               { $$ = context->arena.make<BinaryOprNode>($2, OPR_LESS, $1, $3); }
+    |               expression LESS_EQUAL expression        { $$ = context->arena.make<BinaryOprNode>($2, OPR_LESS_EQUAL, $1, $3); }
+    |               expression EQUAL expression             { $$ = context->arena.make<BinaryOprNode>($2, OPR_EQUAL, $1, $3); }
+    |               expression NOT_EQUAL expression         { $$ = context->arena.make<BinaryOprNode>($2, OPR_NOT_EQUAL, $1, $3); }
+
+    |               '+' expression %prec U_PLUS             { $$ = context->arena.make<UnaryOprNode>($1, OPR_U_PLUS, $2); }
+    |               '-' expression %prec U_MINUM            { $$ = context->arena.make<UnaryOprNode>($1, OPR_U_MINUS, $2); }
+    |               '~' expression                          { $$ = context->arena.make<UnaryOprNode>($1, OPR_NOT, $2); }
+    |               '!' expression                          { $$ = context->arena.make<UnaryOprNode>($1, OPR_LOGICAL_NOT, $2); }
+    ;
+
+expr_2:             INC expr_3 %prec PRE_INC                { $$ = context->arena.make<UnaryOprNode>($1, OPR_PRE_INC, $2); }
+    |               DEC expr_3 %prec PRE_DEC                { $$ = context->arena.make<UnaryOprNode>($1, OPR_PRE_DEC, $2); }
     
-    |               expr_3 INC %prec SUF_INC                { $$ = new UnaryOprNode($2, OPR_SUF_INC, $1); }
-    |               expr_3 DEC %prec SUF_DEC                { $$ = new UnaryOprNode($2, OPR_SUF_DEC, $1); }
+    |               expr_3 INC %prec SUF_INC                { $$ = context->arena.make<UnaryOprNode>($2, OPR_SUF_INC, $1); }
+    |               expr_3 DEC %prec SUF_DEC                { $$ = context->arena.make<UnaryOprNode>($2, OPR_SUF_DEC, $1); }
     ;
 
-expr_3:             '(' expression ')'                      { $$ = new ExprContainerNode($1, $2); }
+expr_3:             '(' expression ')'                      { $$ = context->arena.make<ExprContainerNode>($1, $2); }
 
     |               value                                   { $$ = $1; }
     |               ident                                   { $$ = $1; }
@@ -288,10 +308,10 @@ if_stmt:            unmatched_if_stmt
     |               matched_if_stmt
     ;
 
-unmatched_if_stmt:  IF '(' expression ')' branch_body %prec IF_UNMAT    { $$ = new IfNode($1, $3, $5); }
+unmatched_if_stmt:  IF '(' expression ')' branch_body %prec IF_UNMAT    { $$ = context->arena.make<IfNode>($1, $3, $5); }
     ;
 
-matched_if_stmt:    IF '(' expression ')' branch_body ELSE branch_body  { $$ = new IfNode($1, $3, $5, $7); }
+matched_if_stmt:    IF '(' expression ')' branch_body ELSE branch_body  { $$ = context->arena.make<IfNode>($1, $3, $5, $7); }
     ;
 
 // ------------------------------------------------------------
@@ -299,11 +319,11 @@ matched_if_stmt:    IF '(' expression ')' branch_body ELSE branch_body  { $$ = n
 // Switch Rules
 //
 
-switch_stmt:        SWITCH '(' expression ')' branch_body   { $$ = new SwitchNode($1, $3, $5); }
+switch_stmt:        SWITCH '(' expression ')' branch_body   { $$ = context->arena.make<SwitchNode>($1, $3, $5); }
     ;
 
-case_stmt:          CASE expression ':' stmt                { $$ = new CaseLabelNode($1, $2, $4); }
-    |               DEFAULT ':' stmt                        { $$ = new CaseLabelNode($1, NULL, $3); }
+case_stmt:          CASE expression ':' stmt                { $$ = context->arena.make<CaseLabelNode>($1, $2, $4); }
+    |               DEFAULT ':' stmt                        { $$ = context->arena.make<CaseLabelNode>($1, nullptr, $3); }
     ;
 
 // ------------------------------------------------------------
@@ -311,10 +331,10 @@ case_stmt:          CASE expression ':' stmt                { $$ = new CaseLabel
 // While Rules
 //
 
-while_stmt:         WHILE '(' expression ')' branch_body                { $$ = new WhileNode($1, $3, $5); }
+while_stmt:         WHILE '(' expression ')' branch_body                { $$ = context->arena.make<WhileNode>($1, $3, $5); }
     ;
 
-do_while_stmt:      DO branch_body WHILE '(' expression ')'             { $$ = new DoWhileNode($1, $5, $2); }
+do_while_stmt:      DO branch_body WHILE '(' expression ')'             { $$ = context->arena.make<DoWhileNode>($1, $5, $2); }
     ;
 
 // ------------------------------------------------------------
@@ -325,7 +345,7 @@ do_while_stmt:      DO branch_body WHILE '(' expression ')'             { $$ = n
 for_stmt:           for_header branch_body                              { $$ = $1; $$->body = $2; }
     ;
 
-for_header:         FOR '(' for_init_stmt ';' for_expr ';' for_expr ')' { $$ = new ForNode($1, $3, $5, $7, NULL); }
+for_header:         FOR '(' for_init_stmt ';' for_expr ';' for_expr ')' { $$ = context->arena.make<ForNode>($1, $3, $5, $7, nullptr); }
     ;
 
 for_init_stmt:      /* epsilon */                                       { $$ = NULL; }
@@ -345,32 +365,32 @@ for_expr:           /* epsilon */                                       { $$ = N
 function:           function_header stmt_block          { $$ = $1; $$->body = $2; }
     ;
 
-function_header:    type ident '(' param_list ')'       { $$ = new FunctionNode($1, $2, *$4, NULL); delete $4; }
+function_header:    type ident '(' param_list ')'       { $$ = context->arena.make<FunctionNode>($1, $2, *$4, nullptr); context->beginFunctionBody(); }
     ;
 
-param_list:         /* epsilon */                       { $$ = new VarList(); }
-    |               var_decl                            { $$ = new VarList(); $$->push_back($1); }
+param_list:         /* epsilon */                       { $$ = context->arena.make<VarList>(); }
+    |               var_decl                            { $$ = context->arena.make<VarList>(); $$->push_back($1); }
     |               param_list_ext ',' var_decl         { $$ = $1; $$->push_back($3); }
     ;
 
-param_list_ext:     var_decl                            { $$ = new VarList(); $$->push_back($1); }
+param_list_ext:     var_decl                            { $$ = context->arena.make<VarList>(); $$->push_back($1); }
     |               param_list_ext ',' var_decl         { $$ = $1; $$->push_back($3); }
     ;
 
-function_call:      ident '(' arg_list ')'              { $$ = new FunctionCallNode($1, *$3); delete $3; }
+function_call:      ident '(' arg_list ')'              { $$ = context->arena.make<FunctionCallNode>($1, *$3); }
     ;
 
-arg_list:           /* epsilon */                       { $$ = new ExprList(); }
-    |               expression                          { $$ = new ExprList(); $$->push_back($1); }
+arg_list:           /* epsilon */                       { $$ = context->arena.make<ExprList>(); }
+    |               expression                          { $$ = context->arena.make<ExprList>(); $$->push_back($1); }
     |               arg_list_ext ',' expression         { $$ = $1; $$->push_back($3); }
     ;
 
-arg_list_ext:       expression                          { $$ = new ExprList(); $$->push_back($1); }
+arg_list_ext:       expression                          { $$ = context->arena.make<ExprList>(); $$->push_back($1); }
     |               arg_list_ext ',' expression         { $$ = $1; $$->push_back($3); }
     ;
 
-return_stmt:        RETURN expression                   { $$ = new ReturnStmtNode($1, $2); }
-    |               RETURN                              { $$ = new ReturnStmtNode($1, NULL); }
+return_stmt:        RETURN expression                   { $$ = context->arena.make<ReturnStmtNode>($1, $2); }
+    |               RETURN                              { $$ = context->arena.make<ReturnStmtNode>($1, nullptr); }
     ;
 
 // ------------------------------------------------------------
@@ -378,20 +398,20 @@ return_stmt:        RETURN expression                   { $$ = new ReturnStmtNod
 // Other Rules
 //
 
-type:               TYPE_INT        { $$ = new TypeNode($1, DTYPE_INT); }
-    |               TYPE_FLOAT      { $$ = new TypeNode($1, DTYPE_FLOAT); }
-    |               TYPE_CHAR       { $$ = new TypeNode($1, DTYPE_CHAR); }
-    |               TYPE_BOOL       { $$ = new TypeNode($1, DTYPE_BOOL); }
-    |               TYPE_VOID       { $$ = new TypeNode($1, DTYPE_VOID); }
+type:               TYPE_INT        { $$ = context->arena.make<TypeNode>($1, DTYPE_INT); }
+    |               TYPE_FLOAT      { $$ = context->arena.make<TypeNode>($1, DTYPE_FLOAT); }
+    |               TYPE_CHAR       { $$ = context->arena.make<TypeNode>($1, DTYPE_CHAR); }
+    |               TYPE_BOOL       { $$ = context->arena.make<TypeNode>($1, DTYPE_BOOL); }
+    |               TYPE_VOID       { $$ = context->arena.make<TypeNode>($1, DTYPE_VOID); }
     ;
 
-value:              INTEGER         { $$ = new ValueNode($1.loc, DTYPE_INT, $1.value); delete $1.value; }
-    |               FLOAT           { $$ = new ValueNode($1.loc, DTYPE_FLOAT, $1.value); delete $1.value; }
-    |               CHAR            { $$ = new ValueNode($1.loc, DTYPE_CHAR, $1.value); delete $1.value; }
-    |               BOOL            { $$ = new ValueNode($1.loc, DTYPE_BOOL, $1.value); delete $1.value; }
+value:              INTEGER         { $$ = context->arena.make<ValueNode>($1.loc, DTYPE_INT, context->interns.str($1.id)); }
+    |               FLOAT           { $$ = context->arena.make<ValueNode>($1.loc, DTYPE_FLOAT, context->interns.str($1.id)); }
+    |               CHAR            { $$ = context->arena.make<ValueNode>($1.loc, DTYPE_CHAR, context->interns.str($1.id)); }
+    |               BOOL            { $$ = context->arena.make<ValueNode>($1.loc, DTYPE_BOOL, context->interns.str($1.id)); }
     ;
 
-ident:              IDENTIFIER      { $$ = new IdentifierNode($1.loc, $1.value); delete $1.value; }
+ident:              IDENTIFIER      { $$ = context->arena.make<IdentifierNode>($1.loc, $1.id, context->interns.str($1.id)); }
     ;
 
 %%
@@ -400,6 +420,6 @@ ident:              IDENTIFIER      { $$ = new IdentifierNode($1.loc, $1.value);
 // User Subroutines Section
 // ========================
 
-void yyerror(const char* s) {
+void yyerror(void* scanner, CompileContext* context, const char* s) {
     
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+#ifndef __ARENA_H_
+#define __ARENA_H_
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//
+// Arena definitions
+//
+#define ARENA_BLOCK_SIZE    (1 << 16)
+#define ARENA_ALIGNMENT     alignof(max_align_t)
+
+
+/**
+ * Bump-pointer memory arena.
+ *
+ * Objects are carved out of large memory blocks, and are all released together
+ * when the arena is released, instead of being deleted one by one.
+ * The destructors of the objects needing one are recorded inside the arena itself,
+ * and are called in the reverse order of construction upon release.
+ *
+ * Note that objects owned by an arena must never be deleted.
+ */
+class Arena {
+private:
+    struct Destructor {
+        void (*destroy)(void*);
+        void* obj;
+        Destructor* next;
+    };
+
+    vector<char*> blocks;
+    char* cur = NULL;
+    size_t left = 0;
+    Destructor* dtors = NULL;
+
+    size_t allocCount = 0;
+    size_t usedBytes = 0;
+
+public:
+
+    /**
+     * Struct holding a position in an arena, to rewind the arena to.
+     */
+    struct Mark {
+        size_t blockCount;
+        char* cur;
+        size_t left;
+        Destructor* dtors;
+    };
+
+    Arena() {}
+
+    Arena(const Arena&) = delete;
+
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        release();
+    }
+
+    /**
+     * Allocates a memory region from this arena.
+     *
+     * @param size  the size of the region in bytes.
+     * @param align the alignment of the region, must be a power of two not exceeding {@code ARENA_ALIGNMENT}.
+     *
+     * @return a pointer to the allocated region.
+     */
+    void* allocate(size_t size, size_t align = ARENA_ALIGNMENT) {
+        size_t pad = (align - ((size_t) cur & (align - 1))) & (align - 1);
+
+        if (pad + size > left) {
+            // Large regions get a block of their own, so that the current block is not wasted
+            if (size > ARENA_BLOCK_SIZE / 4) {
+                blocks.push_back(newBlock(size));
+                allocCount++;
+                usedBytes += size;
+                return blocks.back();
+            }
+
+            cur = newBlock(ARENA_BLOCK_SIZE);
+            left = ARENA_BLOCK_SIZE;
+            pad = 0;
+            blocks.push_back(cur);
+        }
+
+        void* ret = cur + pad;
+        cur += pad + size;
+        left -= pad + size;
+
+        allocCount++;
+        usedBytes += size;
+        return ret;
+    }
+
+    /**
+     * Constructs a new object in this arena.
+     *
+     * @param args the arguments to pass to the constructor of the object.
+     *
+     * @return a pointer to the constructed object.
+     */
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* obj = new (allocate(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+
+        if (!is_trivially_destructible<T>::value) {
+            Destructor* d = (Destructor*) allocate(sizeof(Destructor), alignof(Destructor));
+            d->destroy = [](void* ptr) { ((T*) ptr)->~T(); };
+            d->obj = obj;
+            d->next = dtors;
+            dtors = d;
+        }
+
+        return obj;
+    }
+
+    /**
+     * Destructs all the objects of this arena, then releases all of its memory at once.
+     */
+    void release() {
+        for (Destructor* d = dtors; d != NULL; d = d->next) {
+            d->destroy(d->obj);
+        }
+
+        for (int i = 0; i < blocks.size(); ++i) {
+            free(blocks[i]);
+        }
+
+        blocks.clear();
+        cur = NULL;
+        left = 0;
+        dtors = NULL;
+        allocCount = 0;
+        usedBytes = 0;
+    }
+
+    /**
+     * Returns the current position of this arena.
+     */
+    Mark mark() const {
+        return { blocks.size(), cur, left, dtors };
+    }
+
+    /**
+     * Destructs the objects constructed in this arena since the given position,
+     * then releases the memory allocated since then, so that it can be reused.
+     *
+     * The objects constructed before the given position are kept,
+     * and must not refer to the released ones.
+     *
+     * @param m the position to rewind to, taken by {@code mark} since the last release.
+     */
+    void rewind(const Mark& m) {
+        for (Destructor* d = dtors; d != m.dtors; d = d->next) {
+            d->destroy(d->obj);
+        }
+
+        for (size_t i = m.blockCount; i < blocks.size(); ++i) {
+            free(blocks[i]);
+        }
+
+        blocks.resize(m.blockCount);
+        cur = m.cur;
+        left = m.left;
+        dtors = m.dtors;
+    }
+
+    /**
+     * Returns the number of allocations made from this arena since its last release,
+     * including the records of the destructors.
+     */
+    size_t getAllocCount() const {
+        return allocCount;
+    }
+
+    /**
+     * Returns the number of bytes allocated from this arena since its last release, excluding padding.
+     */
+    size_t getUsedBytes() const {
+        return usedBytes;
+    }
+
+    /**
+     * Returns the number of memory blocks currently held by this arena.
+     */
+    size_t getBlockCount() const {
+        return blocks.size();
+    }
+
+private:
+
+    static char* newBlock(size_t size) {
+        char* block = (char*) malloc(size);
+
+        if (block == NULL) {
+            throw bad_alloc();
+        }
+
+        return block;
+    }
+};
+
+#endif
\ No newline at end of file
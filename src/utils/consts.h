@@ -41,6 +41,19 @@ enum Operator {
 	OPR_JMP,				// JMP L1, unconditional jump
     OPR_JNZ,                // JNZ L1, jmp if the top of the stack is not zero and pops it.
 	OPR_JZ, 				// JZ L1, jmp if the top of the stack is zero and pops it.
+    OPR_CONV,               // INT_TO_FLOAT, converts the top of the stack from one type into another
+    OPR_CALL,               // CALL f, calls a procedure
+    OPR_RET,                // RET, returns from the current procedure
+    OPR_DUP,                // DUP, pushes a copy of the top of the stack
+    OPR_JTAB,               // JTAB L1, pops an index and jumps to the matching entry of the following jump table, or to L1 if out of range
+    OPR_CASE,               // CASE L1, jump table entry
+    OPR_JGT,                // JGT L1, pops two operands and jumps if the first is greater than the second
+    OPR_JGE,                // JGE L1, pops two operands and jumps if the first is greater than or equal to the second
+    OPR_JLT,                // JLT L1, pops two operands and jumps if the first is less than the second
+    OPR_JLE,                // JLE L1, pops two operands and jumps if the first is less than or equal to the second
+    OPR_JEQ,                // JEQ L1, pops two operands and jumps if they are equal
+    OPR_JNE,                // JNE L1, pops two operands and jumps if they are not equal
+    OPR_LABEL,              // L1:, label definition pseudo instruction
 };
 
 /**
@@ -71,6 +84,46 @@ enum ScopeType {
     SCOPE_SWITCH,
 };
 
+/**
+ * Enum holding different kinds of quadruple operands.
+ */
+enum OperandKind {
+    OPERAND_NONE = 700,
+    OPERAND_SYMBOL,         // Symbol slot in the symbol table of the procedure
+    OPERAND_VALUE,          // Immediate value
+    OPERAND_LABEL,          // Label id
+    OPERAND_TYPE,           // Target data type of a conversion
+};
+
+/**
+ * Enum holding the kinds of the concrete nodes of the parse tree.
+ */
+enum NodeKind {
+    NODE_STATEMENT = 900,   // ;
+    NODE_ERROR,             // syntax error statement
+    NODE_TYPE,              // int
+    NODE_BLOCK,             // { ... }
+    NODE_VAR_DECL,          // int a = 1
+    NODE_MULTI_VAR_DECL,    // int a = 1, b
+    NODE_IF,                // if (c) ... else ...
+    NODE_CASE_LABEL,        // case 1: ...
+    NODE_SWITCH,            // switch (c) ...
+    NODE_WHILE,             // while (c) ...
+    NODE_DO_WHILE,          // do ... while (c);
+    NODE_FOR,               // for (i; c; u) ...
+    NODE_BREAK,             // break
+    NODE_CONTINUE,          // continue
+    NODE_FUNCTION,          // int f(int a) { ... }
+    NODE_FUNCTION_CALL,     // f(a, b)
+    NODE_RETURN,            // return a
+    NODE_EXPR_CONTAINER,    // (a)
+    NODE_ASSIGN_OPR,        // a = b
+    NODE_BINARY_OPR,        // a + b
+    NODE_UNARY_OPR,         // -a
+    NODE_IDENTIFIER,        // a
+    NODE_VALUE,             // 54
+};
+
 /**
  * Enum holding different logging levels.
  */
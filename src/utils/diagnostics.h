@@ -0,0 +1,272 @@
+#ifndef __DIAGNOSTICS_H_
+#define __DIAGNOSTICS_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "consts.h"
+#include "source_buffer.h"
+#include "utils.h"
+
+using namespace std;
+
+
+/**
+ * The output formats of the diagnostics.
+ */
+enum DiagnosticsFormat {
+    DIAG_TEXT,
+    DIAG_JSON,
+    DIAG_SARIF
+};
+
+/**
+ * Struct holding a single diagnostic message of a compilation.
+ */
+struct Diagnostic {
+    LogLevel level;
+    Location loc;               // The location of the token to point upon, in the columns counted by the lexer
+    string what;                // The message
+    int column;                 // The first column of the token in code points, see resolveColumns
+    int endColumn;              // The column following the token in code points
+};
+
+/**
+ * Class collecting the diagnostics of a compilation, to be rendered and emitted at once when it ends.
+ *
+ * The diagnostics are kept structured rather than formatted as they are logged,
+ * so they can be reordered cheaply (e.g. when combining the results of concurrent analyses),
+ * cut off after an error limit, and rendered either as text or as JSON/SARIF documents.
+ */
+class Diagnostics {
+public:
+    string sourceFilename;
+    vector<Diagnostic> items;
+    int errorLimit = 0;         // The error limit the diagnostics were cut off at, or 0 if none
+
+    /**
+     * Constructs a new diagnostics buffer.
+     *
+     * @param sourceFilename the filename of the source code the diagnostics refer to.
+     */
+    Diagnostics(const string& sourceFilename = "") : sourceFilename(sourceFilename) {
+
+    }
+
+    /**
+     * Adds the given message at the given location to this buffer.
+     *
+     * @param level the log level of this message.
+     * @param what  the message to add.
+     * @param loc   the location of the token to point upon.
+     */
+    void add(LogLevel level, const string& what, const Location& loc) {
+        int column = max(loc.pos, 1);
+        items.push_back({ level, loc, what, column, column + max(loc.len, 1) });
+    }
+
+    /**
+     * Converts the columns of the diagnostics of this buffer into Unicode code points,
+     * as the lexer counts a tab as several columns and a multi-byte character as several ones.
+     * The JSON and SARIF outputs use the converted columns, while the text output keeps the lexer columns
+     * to match the quoted lines, whose tabs are expanded.
+     *
+     * @param source the source code the diagnostics refer to.
+     */
+    void resolveColumns(const SourceBuffer& source) {
+        for (Diagnostic& d : items) {
+            int pos = max(d.loc.pos, 1);
+            d.column = source.codePointColumn(d.loc.lineNum, pos);
+            d.endColumn = max(source.codePointColumn(d.loc.lineNum, pos + max(d.loc.len, 1)), d.column + 1);
+        }
+    }
+
+    /**
+     * Appends the diagnostics in the range {@code [from, to)} of the given buffer to this buffer.
+     */
+    void append(const Diagnostics& other, size_t from, size_t to) {
+        items.insert(items.end(), other.items.begin() + from, other.items.begin() + to);
+    }
+
+    /**
+     * Returns the number of diagnostics in this buffer.
+     */
+    size_t size() const {
+        return items.size();
+    }
+
+    /**
+     * Removes all the diagnostics from this buffer.
+     */
+    void clear() {
+        items.clear();
+    }
+
+    /**
+     * Returns the number of diagnostics of the given log level in this buffer.
+     */
+    int count(LogLevel level) const {
+        int ret = 0;
+
+        for (const Diagnostic& d : items) {
+            ret += (d.level == level);
+        }
+
+        return ret;
+    }
+
+    /**
+     * Drops all the diagnostics following the given number of errors.
+     *
+     * @param maxErrors the maximum number of errors to keep, or 0 to keep all the diagnostics.
+     */
+    void limitErrors(int maxErrors) {
+        if (maxErrors <= 0) {
+            return;
+        }
+
+        int errors = 0;
+
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (items[i].level == LOG_ERROR && ++errors == maxErrors && i + 1 < items.size()) {
+                items.resize(i + 1);
+                errorLimit = maxErrors;
+                break;
+            }
+        }
+    }
+
+    /**
+     * Renders the diagnostics of this buffer as human readable text,
+     * quoting the source line of each diagnostic and underlining its token.
+     *
+     * @param source the source code the diagnostics refer to.
+     *
+     * @return the rendered text.
+     */
+    string toText(const SourceBuffer& source) const {
+        string ret;
+
+        for (const Diagnostic& d : items) {
+            ret += sourceFilename;
+            ret += ':';
+            ret += to_string(d.loc.lineNum);
+            ret += ':';
+            ret += to_string(d.loc.pos);
+            ret += ": ";
+            ret += levelName(d.level);
+            ret += ": ";
+            ret += d.what;
+            ret += '\n';
+
+            source.appendLine(ret, d.loc.lineNum);
+            ret += '\n';
+            ret.append(max(d.loc.pos - 1, 0), ' ');
+            ret += '^';
+            ret.append(max(d.loc.len - 1, 0), '~');
+            ret += '\n';
+        }
+
+        if (errorLimit > 0) {
+            ret += sourceFilename + ": note: stopped reporting after " + to_string(errorLimit) + " errors\n";
+        }
+
+        return ret;
+    }
+
+    /**
+     * Renders the diagnostics of the given buffers as a single JSON document.
+     *
+     * @param files the diagnostics of each compiled file, in order.
+     *
+     * @return the JSON document, ending with a new line.
+     */
+    static string toJson(const vector<const Diagnostics*>& files) {
+        string ret = "{\"diagnostics\": [";
+        int errors = 0, warnings = 0;
+        bool truncated = false;
+        bool first = true;
+
+        for (const Diagnostics* file : files) {
+            for (const Diagnostic& d : file->items) {
+                ret += (first ? "\n  " : ",\n  ");
+                ret += "{\"file\": \"" + Utils::escapeJson(file->sourceFilename) + "\"";
+                ret += ", \"line\": " + to_string(d.loc.lineNum);
+                ret += ", \"column\": " + to_string(d.column);
+                ret += ", \"length\": " + to_string(d.endColumn - d.column);
+                ret += ", \"level\": \"" + string(levelName(d.level)) + "\"";
+                ret += ", \"message\": \"" + Utils::escapeJson(d.what) + "\"}";
+                first = false;
+            }
+
+            errors += file->count(LOG_ERROR);
+            warnings += file->count(LOG_WARNING);
+            truncated |= (file->errorLimit > 0);
+        }
+
+        ret += (first ? "]" : "\n]");
+        ret += ", \"errors\": " + to_string(errors);
+        ret += ", \"warnings\": " + to_string(warnings);
+        ret += ", \"truncated\": " + string(truncated ? "true" : "false");
+        return ret + "}\n";
+    }
+
+    /**
+     * Renders the diagnostics of the given buffers as a single SARIF 2.1.0 log, with one run of the compiler.
+     *
+     * @param files       the diagnostics of each compiled file, in order.
+     * @param toolName    the name of the compiler.
+     * @param toolVersion the version of the compiler.
+     *
+     * @return the SARIF log, ending with a new line.
+     */
+    static string toSarif(const vector<const Diagnostics*>& files, const string& toolName, const string& toolVersion) {
+        string ret;
+        bool first = true;
+
+        ret += "{\n";
+        ret += "  \"$schema\": \"https://json.schemastore.org/sarif-2.1.0.json\",\n";
+        ret += "  \"version\": \"2.1.0\",\n";
+        ret += "  \"runs\": [{\n";
+        ret += "    \"tool\": {\"driver\": {\"name\": \"" + Utils::escapeJson(toolName) + "\", ";
+        ret += "\"version\": \"" + Utils::escapeJson(toolVersion) + "\"}},\n";
+        ret += "    \"columnKind\": \"unicodeCodePoints\",\n";
+        ret += "    \"results\": [";
+
+        for (const Diagnostics* file : files) {
+            string uri = Utils::escapeJson(file->sourceFilename);
+
+            for (const Diagnostic& d : file->items) {
+                ret += (first ? "\n      " : ",\n      ");
+                ret += "{\"level\": \"" + string(levelName(d.level)) + "\"";
+                ret += ", \"message\": {\"text\": \"" + Utils::escapeJson(d.what) + "\"}";
+                ret += ", \"locations\": [{\"physicalLocation\": {\"artifactLocation\": {\"uri\": \"" + uri + "\"}";
+                ret += ", \"region\": {\"startLine\": " + to_string(max(d.loc.lineNum, 1));
+                ret += ", \"startColumn\": " + to_string(d.column);
+                ret += ", \"endColumn\": " + to_string(d.endColumn) + "}}}]}";
+                first = false;
+            }
+        }
+
+        ret += (first ? "]\n" : "\n    ]\n");
+        ret += "  }]\n";
+        return ret + "}\n";
+    }
+
+    /**
+     * Returns the name of the given log level, as used by both the text and the SARIF outputs.
+     */
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+            case LOG_ERROR:
+                return "error";
+            case LOG_WARNING:
+                return "warning";
+            default:
+                return "note";
+        }
+    }
+};
+
+#endif
\ No newline at end of file
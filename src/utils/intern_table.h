@@ -0,0 +1,222 @@
+#ifndef __INTERN_TABLE_H_
+#define __INTERN_TABLE_H_
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+using namespace std;
+
+//
+// Intern table definitions
+//
+#define INTERN_INITIAL_SLOTS    1024
+#define INTERN_CHUNK_BITS       12                          // The size of the first chunk is 2^12 strings
+#define INTERN_MAX_CHUNKS       (32 - INTERN_CHUNK_BITS)    // Each chunk doubles the previous one, covering all the handles
+
+
+/**
+ * Interned string handle.
+ *
+ * Equal strings are interned into the same handle, so strings can be compared
+ * and hashed through their handles. Handles are dense integers starting from zero.
+ */
+typedef int InternId;
+
+/**
+ * Table of unique strings, mapping each string into a dense integer handle.
+ *
+ * The strings are stored once and never moved, so references to them remain valid
+ * for the lifetime of the table. Each compilation owns its table (see {@code CompileContext}),
+ * so the table holds the strings of a single file and is released along with it.
+ *
+ * The table is safe for concurrent use: interning is serialized by a lock,
+ * while the strings are stored in chunks that are published atomically,
+ * so that looking up the string of a handle never blocks.
+ * The chunks double in size, so the table grows up to the range of the handles
+ * with a small fixed directory of chunks.
+ */
+class InternTable {
+private:
+    atomic<string*> chunks[INTERN_MAX_CHUNKS];  // The interned strings in growing chunks, indexed by handle
+    atomic<size_t> count;                       // The number of interned strings
+    vector<uint32_t> hashes;                    // The hash of each interned string, indexed by handle
+    vector<InternId> slots;                     // Open addressing hash table of handles, -1 for empty slots
+    mutex lock;
+
+public:
+
+    InternTable() : count(0) {
+        for (int i = 0; i < INTERN_MAX_CHUNKS; ++i) {
+            chunks[i].store(NULL, memory_order_relaxed);
+        }
+
+        slots.assign(INTERN_INITIAL_SLOTS, -1);
+    }
+
+    InternTable(const InternTable&) = delete;
+
+    InternTable& operator=(const InternTable&) = delete;
+
+    ~InternTable() {
+        for (int i = 0; i < INTERN_MAX_CHUNKS; ++i) {
+            delete[] chunks[i].load(memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Interns the given string.
+     *
+     * @param str the characters of the string.
+     * @param len the length of the string.
+     *
+     * @return the handle of the string.
+     */
+    InternId intern(const char* str, size_t len) {
+        uint32_t h = hash(str, len);
+
+        lock_guard<mutex> guard(lock);
+
+        size_t mask = slots.size() - 1;
+
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            InternId id = slots[i];
+
+            if (id < 0) {
+                id = append(string(str, len));
+                hashes.push_back(h);
+                slots[i] = id;
+
+                // Keep the load factor below one half
+                if (hashes.size() * 2 > slots.size()) {
+                    grow();
+                }
+
+                return id;
+            }
+
+            const string& s = this->str(id);
+
+            if (hashes[id] == h && s.size() == len && memcmp(s.data(), str, len) == 0) {
+                return id;
+            }
+        }
+    }
+
+    /**
+     * Interns the given string.
+     *
+     * @param str the string to intern.
+     *
+     * @return the handle of the string.
+     */
+    InternId intern(const string& str) {
+        return intern(str.data(), str.size());
+    }
+
+    /**
+     * Returns the string of the given handle.
+     *
+     * @param id the handle of the string.
+     *
+     * @return the interned string.
+     */
+    const string& str(InternId id) const {
+        size_t offset;
+        int c = locate(id, offset);
+        return chunks[c].load(memory_order_acquire)[offset];
+    }
+
+    /**
+     * Returns the number of interned strings.
+     */
+    size_t size() const {
+        return count.load(memory_order_acquire);
+    }
+
+private:
+
+    /**
+     * Stores the given string after the last interned string, must be called while holding the lock.
+     *
+     * @param s the string to store.
+     *
+     * @return the handle of the stored string.
+     */
+    InternId append(string&& s) {
+        size_t id = count.load(memory_order_relaxed);
+
+        // The handles run out long after the memory does, as each string takes tens of bytes
+        if (id > INT_MAX) {
+            throw length_error("intern table is full");
+        }
+
+        size_t offset;
+        int c = locate((InternId) id, offset);
+        string* chunk = chunks[c].load(memory_order_relaxed);
+
+        if (chunk == NULL) {
+            chunk = new string[(size_t) 1 << (INTERN_CHUNK_BITS + c)];
+            chunks[c].store(chunk, memory_order_release);
+        }
+
+        chunk[offset] = move(s);
+        count.store(id + 1, memory_order_release);
+        return (InternId) id;
+    }
+
+    /**
+     * Locates the given handle in the chunks, where the chunk {@code c} holds {@code 2^(INTERN_CHUNK_BITS + c)} strings.
+     *
+     * @param id     the handle to locate.
+     * @param offset the offset of the handle in its chunk, set by this function.
+     *
+     * @return the index of the chunk of the handle.
+     */
+    static int locate(InternId id, size_t& offset) {
+        size_t n = (size_t) id + ((size_t) 1 << INTERN_CHUNK_BITS);
+        int c = 0;
+
+        while ((n >> (INTERN_CHUNK_BITS + c + 1)) != 0) {
+            c++;
+        }
+
+        offset = n - ((size_t) 1 << (INTERN_CHUNK_BITS + c));
+        return c;
+    }
+
+    void grow() {
+        slots.assign(slots.size() * 2, -1);
+        size_t mask = slots.size() - 1;
+
+        for (InternId id = 0; id < hashes.size(); ++id) {
+            size_t i = hashes[id] & mask;
+
+            while (slots[i] >= 0) {
+                i = (i + 1) & mask;
+            }
+
+            slots[i] = id;
+        }
+    }
+
+    /**
+     * FNV-1a hash function.
+     */
+    static uint32_t hash(const char* str, size_t len) {
+        uint32_t h = 2166136261u;
+
+        for (size_t i = 0; i < len; ++i) {
+            h = (h ^ (unsigned char) str[i]) * 16777619u;
+        }
+
+        return h;
+    }
+};
+
+#endif
\ No newline at end of file
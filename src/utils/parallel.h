@@ -0,0 +1,63 @@
+#ifndef __PARALLEL_H_
+#define __PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Returns the default number of worker threads, that is the number of cores.
+ */
+inline int defaultThreadCount() {
+    return max((int) thread::hardware_concurrency(), 1);
+}
+
+/**
+ * Calls the given function for each index in {@code [0, count)} on a pool of worker threads.
+ *
+ * The indices are handed to the workers in increasing order, one at a time,
+ * and the calling thread is one of the workers. The function returns after all calls are completed.
+ *
+ * @param count   the number of indices.
+ * @param threads the maximum number of worker threads.
+ * @param func    the function to call with each index and the index of the calling worker,
+ *                less than the number of worker threads.
+ */
+template<typename Func>
+void parallelFor(size_t count, int threads, Func func) {
+    threads = (int) max(min((size_t) threads, count), (size_t) 1);
+
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i, 0);
+        }
+
+        return;
+    }
+
+    atomic<size_t> next(0);
+
+    auto worker = [&](int w) {
+        for (size_t i; (i = next.fetch_add(1)) < count; ) {
+            func(i, w);
+        }
+    };
+
+    vector<thread> pool;
+
+    for (int w = 1; w < threads; ++w) {
+        pool.emplace_back(worker, w);
+    }
+
+    worker(0);
+
+    for (int i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+}
+
+#endif
\ No newline at end of file
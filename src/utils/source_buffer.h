@@ -0,0 +1,252 @@
+#ifndef __SOURCE_BUFFER_H_
+#define __SOURCE_BUFFER_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+//
+// Source Buffer definitions
+//
+#define SOURCE_READ_CHUNK   (1 << 16)   // The size of the chunks to read the file in, if it cannot be mapped
+#define SOURCE_TAB_WIDTH    4           // The number of spaces a tab is expanded into, as counted by the lexer
+
+
+/**
+ * Class holding the source code of a compilation, loaded once and shared by the lexer and the diagnostics.
+ *
+ * The file is mapped into memory if possible, or read into a string otherwise.
+ * The lexer consumes the buffer through {@code read}, while the diagnostics quote its lines through {@code appendLine}.
+ * The lines are only indexed when first quoted, with a table of the offsets where each line begins,
+ * so a compilation without diagnostics never splits the source code into lines.
+ */
+class SourceBuffer {
+    const char* begin = NULL;               // The first byte of the source code
+    size_t length = 0;                      // The size of the source code in bytes
+    size_t cursor = 0;                      // The offset of the next byte to hand to the lexer
+    bool mapped = false;                    // Whether the source code is mapped into memory, or held by contents
+    string contents;                        // The source code, if it could not be mapped
+    mutable vector<size_t> lineStarts;      // The offset of the first byte of each line, computed on first use
+
+public:
+
+    /**
+     * Constructs a new empty source buffer.
+     */
+    SourceBuffer() {
+
+    }
+
+    SourceBuffer(const SourceBuffer&) = delete;
+
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    /**
+     * Destructs this source buffer, unmapping its file.
+     */
+    ~SourceBuffer() {
+        close();
+    }
+
+    /**
+     * Loads the given source code file into this buffer, replacing its previous contents.
+     *
+     * @param filename the filename of the source code.
+     *
+     * @return {@code true} if the file was loaded, {@code false} if it could not be opened.
+     */
+    bool open(const string& filename) {
+        close();
+
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+
+        // Empty files cannot be mapped, and special files (e.g. pipes) have no size to map
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (addr != MAP_FAILED) {
+                begin = (const char*) addr;
+                length = st.st_size;
+                mapped = true;
+            }
+        }
+
+        ::close(fd);
+
+        if (mapped) {
+            return true;
+        }
+#endif
+
+        FILE* in = fopen(filename.c_str(), "rb");
+
+        if (in == NULL) {
+            return false;
+        }
+
+        char chunk[SOURCE_READ_CHUNK];
+        size_t n;
+
+        while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+            contents.append(chunk, n);
+        }
+
+        fclose(in);
+
+        begin = contents.data();
+        length = contents.size();
+        return true;
+    }
+
+    /**
+     * Releases the contents of this buffer, unmapping its file.
+     */
+    void close() {
+#ifndef _WIN32
+        if (mapped) {
+            munmap((void*) begin, length);
+        }
+#endif
+
+        begin = NULL;
+        length = 0;
+        cursor = 0;
+        mapped = false;
+        contents.clear();
+        lineStarts.clear();
+    }
+
+    /**
+     * Copies the next bytes of the source code into the given buffer of the lexer.
+     *
+     * @param buf     the buffer to copy into.
+     * @param maxSize the size of the buffer.
+     *
+     * @return the number of bytes copied, or 0 at the end of the source code.
+     */
+    size_t read(char* buf, size_t maxSize) {
+        size_t n = min(maxSize, length - cursor);
+        memcpy(buf, begin + cursor, n);
+        cursor += n;
+        return n;
+    }
+
+    /**
+     * Returns the number of lines of the source code.
+     */
+    int lineCount() const {
+        indexLines();
+        return lineStarts.size();
+    }
+
+    /**
+     * Appends the given line of the source code to the given string, expanding its tabs into spaces
+     * to match the columns counted by the lexer.
+     *
+     * This method indexes the lines on first use, so it must not be called concurrently with itself.
+     *
+     * @param out     the string to append to.
+     * @param lineNum the 1-based number of the line. Nothing is appended if there is no such line.
+     */
+    void appendLine(string& out, int lineNum) const {
+        indexLines();
+
+        if (lineNum < 1 || lineNum > lineStarts.size()) {
+            return;
+        }
+
+        const char* p = begin + lineStarts[lineNum - 1];
+        const char* end = begin + (lineNum < lineStarts.size() ? lineStarts[lineNum] - 1 : length);
+
+        // The last line may end with a new line, which does not start another line
+        if (end > p && end[-1] == '\n') {
+            end--;
+        }
+
+        while (p < end) {
+            const char* tab = (const char*) memchr(p, '\t', end - p);
+
+            if (tab == NULL) {
+                out.append(p, end - p);
+                break;
+            }
+
+            out.append(p, tab - p);
+            out.append(SOURCE_TAB_WIDTH, ' ');
+            p = tab + 1;
+        }
+    }
+
+    /**
+     * Converts the given column counted by the lexer, where a tab takes {@code SOURCE_TAB_WIDTH} columns,
+     * a carriage return takes none and every other byte takes one,
+     * into the column of the same position counted in Unicode code points.
+     *
+     * This method indexes the lines on first use, so it must not be called concurrently with itself.
+     *
+     * @param lineNum the 1-based number of the line.
+     * @param pos     the 1-based column counted by the lexer.
+     *
+     * @return the 1-based column in code points, or {@code pos} itself if there is no such line.
+     */
+    int codePointColumn(int lineNum, int pos) const {
+        indexLines();
+
+        if (lineNum < 1 || lineNum > lineStarts.size()) {
+            return pos;
+        }
+
+        const char* p = begin + lineStarts[lineNum - 1];
+        const char* end = begin + (lineNum < lineStarts.size() ? lineStarts[lineNum] : length);
+        int col = 1, ret = 1;
+
+        // Count the code points before the column, skipping the continuation bytes of UTF-8 sequences
+        for (; p < end && col < pos && *p != '\n'; ++p) {
+            col += (*p == '\t' ? SOURCE_TAB_WIDTH : *p == '\r' ? 0 : 1);
+            ret += ((*p & 0xC0) != 0x80);
+        }
+
+        // Columns past the end of the line are kept as they are
+        return ret + max(pos - col, 0);
+    }
+
+private:
+
+    /**
+     * Fills the table of the offsets where each line begins, if not filled yet.
+     */
+    void indexLines() const {
+        if (!lineStarts.empty() || length == 0) {
+            return;
+        }
+
+        const char* p = begin;
+        const char* end = begin + length;
+
+        lineStarts.push_back(0);
+
+        while ((p = (const char*) memchr(p, '\n', end - p)) != NULL && ++p < end) {
+            lineStarts.push_back(p - begin);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
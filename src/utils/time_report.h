@@ -0,0 +1,255 @@
+#ifndef __TIME_REPORT_H_
+#define __TIME_REPORT_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+//
+// The heap allocation counters of the compiler, maintained by its global allocation function
+//
+extern thread_local size_t heapAllocCount;      // The heap allocations of the calling thread
+extern atomic<size_t> sharedHeapAllocCount;     // The heap allocations of all threads, if counted
+
+
+/**
+ * The phases of a compilation measured by the time report.
+ */
+enum Phase {
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_ANALYZE,
+    PHASE_GENERATE,
+    PHASE_SYMBOLS,
+    PHASE_OUTPUT,
+    PHASE_COUNT
+};
+
+/**
+ * Struct holding the cost of a single phase of a compilation.
+ */
+struct PhaseCost {
+    double wall = 0;        // The wall time in milliseconds
+    double cpu = 0;         // The CPU time in milliseconds
+    long peakRss = 0;       // The peak resident set size of the process by the end of the phase, in KB
+    size_t allocs = 0;      // The number of heap allocations
+
+    /**
+     * Adds the cost of the same phase of another compilation to this cost.
+     */
+    void merge(const PhaseCost& other) {
+        wall += other.wall;
+        cpu += other.cpu;
+        peakRss = max(peakRss, other.peakRss);
+        allocs += other.allocs;
+    }
+};
+
+/**
+ * Class measuring the wall time, the CPU time, the peak memory and the heap allocations
+ * of each phase of a compilation.
+ *
+ * The compilation calls {@code enter} whenever it moves from a phase to another.
+ * The wall time and the allocations are sampled at every switch, which is cheap enough to be done per token.
+ * The CPU time and the peak memory need a system call, so they are only sampled at the exact switches:
+ * the CPU time since the previous exact switch is split between the phases entered meanwhile
+ * in proportion to their wall time (e.g. between lexing and parsing, which alternate per token).
+ */
+class TimeReport {
+public:
+    PhaseCost phases[PHASE_COUNT];
+    bool shared;                        // Whether to measure the whole process or the calling thread only
+
+private:
+    int current = -1;                   // The phase being measured, or -1 if none
+    double lastWall = 0;                // The wall time at the last switch
+    double lastCpu = 0;                 // The CPU time at the last exact switch
+    size_t lastAllocs = 0;              // The allocation count at the last switch
+    double pending[PHASE_COUNT] = {};   // The wall time of each phase since the last exact switch
+
+public:
+
+    /**
+     * Constructs a new time report.
+     *
+     * @param shared whether to measure the whole process, including the worker threads of the compilation,
+     *               or only the calling thread, when other compilations run concurrently in the same process.
+     */
+    TimeReport(bool shared = true) : shared(shared) {
+
+    }
+
+    /**
+     * Charges the costs since the last switch to the current phase, then starts measuring the given phase.
+     *
+     * @param phase the phase to measure, or -1 to stop measuring.
+     * @param exact whether to sample the CPU time and the peak memory as well.
+     */
+    void enter(int phase, bool exact = true) {
+        double wall = wallTime();
+        size_t allocs = allocCount();
+
+        if (current >= 0) {
+            phases[current].wall += wall - lastWall;
+            phases[current].allocs += allocs - lastAllocs;
+            pending[current] += wall - lastWall;
+        }
+
+        if (exact) {
+            double cpu = cpuTime();
+            long rss = peakRss();
+            double total = 0;
+
+            for (int i = 0; i < PHASE_COUNT; ++i) {
+                total += pending[i];
+            }
+
+            for (int i = 0; i < PHASE_COUNT; ++i) {
+                if (pending[i] > 0) {
+                    phases[i].cpu += (cpu - lastCpu) * pending[i] / total;
+                    phases[i].peakRss = max(phases[i].peakRss, rss);
+                    pending[i] = 0;
+                }
+            }
+
+            lastCpu = cpu;
+        }
+
+        lastWall = wall;
+        lastAllocs = allocs;
+        current = phase;
+    }
+
+    /**
+     * Returns the phase being measured, or -1 if none.
+     */
+    int phase() const {
+        return current;
+    }
+
+    /**
+     * Adds the costs of another compilation to this report, phase by phase.
+     */
+    void merge(const TimeReport& other) {
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            phases[i].merge(other.phases[i]);
+        }
+    }
+
+    /**
+     * Returns the total cost of all the phases.
+     */
+    PhaseCost total() const {
+        PhaseCost ret;
+
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            ret.merge(phases[i]);
+        }
+
+        return ret;
+    }
+
+    /**
+     * Formats this report as a human readable table, one line per phase.
+     */
+    string toText() const {
+        string ret = "time report:        wall (ms)    cpu (ms)   peak RSS (KB)   heap allocations\n";
+
+        for (int i = 0; i <= PHASE_COUNT; ++i) {
+            PhaseCost cost = (i < PHASE_COUNT ? phases[i] : total());
+            char line[256];
+
+            snprintf(line, sizeof(line), "  %-16s %12.3f %11.3f %15ld %18zu\n",
+                     i < PHASE_COUNT ? phaseName(i) : "total", cost.wall, cost.cpu, cost.peakRss, cost.allocs);
+            ret += line;
+        }
+
+        return ret;
+    }
+
+    /**
+     * Formats this report as a single line JSON object, with a member per phase and a total.
+     */
+    string toJson() const {
+        string ret = "{";
+
+        for (int i = 0; i <= PHASE_COUNT; ++i) {
+            PhaseCost cost = (i < PHASE_COUNT ? phases[i] : total());
+            char member[256];
+
+            snprintf(member, sizeof(member),
+                     "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_kb\": %ld, \"heap_allocations\": %zu}",
+                     i > 0 ? ", " : "", i < PHASE_COUNT ? phaseName(i) : "total",
+                     cost.wall, cost.cpu, cost.peakRss, cost.allocs);
+            ret += member;
+        }
+
+        return ret + "}\n";
+    }
+
+    /**
+     * Returns the name of the given phase.
+     */
+    static const char* phaseName(int phase) {
+        static const char* names[PHASE_COUNT] = {
+            "lexing", "parsing", "analysis", "generation", "symbol_table", "output"
+        };
+
+        return names[phase];
+    }
+
+private:
+
+    /**
+     * Returns the current wall time in milliseconds.
+     */
+    static double wallTime() {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Returns the CPU time consumed so far in milliseconds, by the process or by the calling thread.
+     */
+    double cpuTime() const {
+#ifndef _WIN32
+        struct timespec ts;
+
+        if (clock_gettime(shared ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+            return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+        }
+#endif
+        return clock() * 1e3 / CLOCKS_PER_SEC;
+    }
+
+    /**
+     * Returns the number of heap allocations made so far, by all threads or by the calling thread.
+     */
+    size_t allocCount() const {
+        return shared ? sharedHeapAllocCount.load(memory_order_relaxed) : heapAllocCount;
+    }
+
+    /**
+     * Returns the peak resident set size of the process so far in KB, or 0 if unknown.
+     */
+    static long peakRss() {
+#ifndef _WIN32
+        struct rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            return usage.ru_maxrss;
+        }
+#endif
+        return 0;
+    }
+};
+
+#endif
\ No newline at end of file
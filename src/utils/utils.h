@@ -3,9 +3,13 @@
 
 #include <string>
 #include <vector>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
 #include <unordered_map>
 
 #include "consts.h"
+#include "intern_table.h"
 
 using namespace std;
 
@@ -33,7 +37,7 @@ struct Location {
  * Struct holding the basic information of the tokens.
  */
 struct Token {
-    char* value;
+    InternId id;            // The interned text of the token
     Location loc;
 };
 
@@ -63,6 +67,39 @@ struct Utils {
         return ret;
     }
 
+    /**
+     * Escapes the given string to be embedded in a JSON string literal.
+     *
+     * @param str the string to escape.
+     *
+     * @return the escaped string, without the surrounding quotes.
+     */
+    static string escapeJson(const string& str) {
+        string ret;
+        ret.reserve(str.size());
+
+        for (int i = 0; i < str.size(); ++i) {
+            unsigned char c = str[i];
+
+            if (c == '"' || c == '\\') {
+                ret += '\\';
+                ret += c;
+            } else if (c == '\n') {
+                ret += "\\n";
+            } else if (c == '\t') {
+                ret += "\\t";
+            } else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                ret += buf;
+            } else {
+                ret += c;
+            }
+        }
+
+        return ret;
+    }
+
     /**
      * Checks whether the given operator is an arithmetic operator or not.
      *
@@ -107,6 +144,42 @@ struct Utils {
         return false;
     }
 
+    /**
+     * Checks whether the given operator is a relational operator or not.
+     *
+     * @param opr the operator to check.
+     *
+     * @return {@code true} if the given operator is relational; {@code false} otherwise.
+     */
+    static bool isRelationalOpr(Operator opr) {
+        return opr >= OPR_GREATER && opr <= OPR_NOT_EQUAL;
+    }
+
+    /**
+     * Returns the compare-and-branch operator of the given relational operator.
+     *
+     * @param opr    the relational operator.
+     * @param jumpIf whether to jump if the relation holds, or if it does not hold.
+     *
+     * @return the compare-and-branch operator (e.g. {@code OPR_JLT}).
+     */
+    static Operator relationalToJump(Operator opr, bool jumpIf) {
+        switch (opr) {
+            case OPR_GREATER:
+                return jumpIf ? OPR_JGT : OPR_JLE;
+            case OPR_GREATER_EQUAL:
+                return jumpIf ? OPR_JGE : OPR_JLT;
+            case OPR_LESS:
+                return jumpIf ? OPR_JLT : OPR_JGE;
+            case OPR_LESS_EQUAL:
+                return jumpIf ? OPR_JLE : OPR_JGT;
+            case OPR_EQUAL:
+                return jumpIf ? OPR_JEQ : OPR_JNE;
+            default:
+                return jumpIf ? OPR_JNE : OPR_JEQ;
+        }
+    }
+
     /**
      * Checks whether the given operator is a bitwise operator or not.
      *
@@ -275,6 +348,28 @@ struct Utils {
 				return "JNZ_" + dtypeToQuad(type);
 			case OPR_JZ:
 				return "JZ_" + dtypeToQuad(type);
+            case OPR_CALL:
+                return "CALL";
+            case OPR_RET:
+                return "RET";
+            case OPR_DUP:
+                return "DUP_" + dtypeToQuad(type);
+            case OPR_JTAB:
+                return "JTAB";
+            case OPR_CASE:
+                return "CASE";
+            case OPR_JGT:
+                return "JGT_" + dtypeToQuad(type);
+            case OPR_JGE:
+                return "JGE_" + dtypeToQuad(type);
+            case OPR_JLT:
+                return "JLT_" + dtypeToQuad(type);
+            case OPR_JLE:
+                return "JLE_" + dtypeToQuad(type);
+            case OPR_JEQ:
+                return "JEQ_" + dtypeToQuad(type);
+            case OPR_JNE:
+                return "JNE_" + dtypeToQuad(type);
         }
 
         return "#";
@@ -347,6 +442,148 @@ struct Utils {
         return "unknown";
     }
 
+    /**
+     * Parses the given literal string into a value of the given data type.
+     *
+     * @param str  the literal as written in the source code.
+     * @param type the data type of the literal.
+     *
+     * @return the parsed value.
+     */
+    static Value strToValue(const string& str, DataType type) {
+        Value val;
+        val.intVal = 0;
+
+        switch (type) {
+            case DTYPE_BOOL:
+                val.boolVal = (str == "true");
+                break;
+            case DTYPE_CHAR:
+                val.charVal = str[1];
+                break;
+            case DTYPE_INT:
+                val.intVal = atoi(str.c_str());
+                break;
+            case DTYPE_FLOAT:
+                val.floatVal = strtof(str.c_str(), NULL);
+                break;
+        }
+
+        return val;
+    }
+
+    /**
+     * Converts the given integer into a value of the given integer data type.
+     *
+     * @param v    the integer to convert.
+     * @param type the data type of the resulting value.
+     *
+     * @return the converted value.
+     */
+    static Value intToValue(int v, DataType type) {
+        Value val;
+        val.intVal = 0;
+
+        switch (type) {
+            case DTYPE_BOOL:
+                val.boolVal = (v != 0);
+                break;
+            case DTYPE_CHAR:
+                val.charVal = (char) v;
+                break;
+            case DTYPE_FLOAT:
+                val.floatVal = (float) v;
+                break;
+            default:
+                val.intVal = v;
+                break;
+        }
+
+        return val;
+    }
+
+    /**
+     * Converts the given value from one primitive data type into another,
+     * in the same way the conversion instructions do (e.g. {@code INT_TO_FLOAT}).
+     *
+     * @param val  the value to convert.
+     * @param from the data type of the given value.
+     * @param to   the data type to convert into.
+     *
+     * @return the converted value.
+     */
+    static Value convertValue(const Value& val, DataType from, DataType to) {
+        if (from == to) {
+            return val;
+        }
+
+        switch (from) {
+            case DTYPE_BOOL:
+                return intToValue(val.boolVal, to);
+            case DTYPE_CHAR:
+                return intToValue(val.charVal, to);
+            case DTYPE_INT:
+                return intToValue(val.intVal, to);
+        }
+
+        // Float value
+        Value ret;
+        ret.intVal = 0;
+
+        switch (to) {
+            case DTYPE_BOOL:
+                ret.boolVal = (val.floatVal != 0);
+                break;
+            case DTYPE_CHAR:
+                ret.charVal = (char) val.floatVal;
+                break;
+            case DTYPE_INT:
+                ret.intVal = (int) val.floatVal;
+                break;
+        }
+
+        return ret;
+    }
+
+    /**
+     * Converts the given value into its corresponding quadruple string.
+     *
+     * Float values are printed using the shortest representation
+     * that converts back into the same value. The infinities and NaNs are always signed
+     * (e.g. {@code +inf}), so they cannot be taken for symbols of the same name.
+     *
+     * @param val  the value to convert.
+     * @param type the data type of the value.
+     *
+     * @return the corresponding quadruple string.
+     */
+    static string valueToQuad(const Value& val, DataType type) {
+        char buf[32];
+
+        switch (type) {
+            case DTYPE_BOOL:
+                return val.boolVal ? "true" : "false";
+            case DTYPE_CHAR:
+                if (!isprint((unsigned char) val.charVal)) {
+                    return to_string((int) val.charVal);
+                }
+                return string("'") + val.charVal + "'";
+            case DTYPE_INT:
+                return to_string(val.intVal);
+            case DTYPE_FLOAT:
+                for (int precision = 1; precision <= 9; ++precision) {
+                    snprintf(buf, sizeof(buf), "%.*g", precision, val.floatVal);
+
+                    if (strtof(buf, NULL) == val.floatVal) {
+                        break;
+                    }
+                }
+                return isalpha((unsigned char) buf[0]) ? string("+") + buf : buf;
+        }
+
+        return "#";
+    }
+
     /**
      * Convert data type from t1 into t2.
      *
@@ -356,7 +593,7 @@ struct Utils {
      * @return the corresponding quadruple string.
      */
     static string dtypeConvQuad(DataType t1, DataType t2) {
-        return (t1 != t2 ? dtypeToQuad(t1) + "_TO_" + dtypeToQuad(t2) + "\n" : "");
+        return (t1 != t2 ? dtypeToQuad(t1) + "_TO_" + dtypeToQuad(t2) : "");
     }
 };
 
@@ -0,0 +1,195 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <chrono>
+
+#include "vm.h"
+#include "../quadruples/quad_image.h"
+#include "../quadruples/quad_reader.h"
+
+using namespace std;
+
+//
+// Virtual machine definitions
+//
+#define VM_NAME             "mpp-run"
+#define VERSION             "1.0"
+
+//
+// Global Variables
+//
+string inputFilename;
+bool showStats = false;
+
+//
+// Functions prototypes
+//
+bool loadImage(const string& filename, QuadImage& image);
+void printHelp();
+void parseArguments(int argc, char* argv[]);
+
+
+/**
+ * Virtual machine driver program.
+ *
+ * @param argc the number of arguments sent to the program.
+ * @param argv the arguments them self as sent to the program.
+ */
+int main(int argc, char* argv[]) {
+    // Parse incoming arguments
+    parseArguments(argc, argv);
+
+    // Load the quadruples
+    QuadImage image;
+
+    if (!loadImage(inputFilename, image)) {
+        return 1;
+    }
+
+    // Execute the program
+    QuadVM vm(image);
+
+    auto start = chrono::steady_clock::now();
+    bool ok = vm.run();
+    auto end = chrono::steady_clock::now();
+
+    if (!ok) {
+        fprintf(stderr, "runtime error: %s!\n", vm.getError().c_str());
+    }
+
+    if (showStats) {
+        double secs = chrono::duration<double>(end - start).count();
+        unsigned long long count = vm.getRetiredCount();
+
+        fprintf(stderr, "instructions retired: %llu\n", count);
+        fprintf(stderr, "execution time:       %.6f s\n", secs);
+        fprintf(stderr, "throughput:           %.2f M instructions/s\n", secs > 0 ? count / secs / 1e6 : 0.0);
+    }
+
+    return ok ? vm.getExitCode() : 1;
+}
+
+/**
+ * Loads the given quadruples file, either a binary image or a quadruples text file.
+ *
+ * Text files are parsed and translated into an in-memory binary image.
+ *
+ * @param filename the filename of the quadruples file.
+ * @param image    the image to load into.
+ *
+ * @return {@code true} if the file was loaded successfully; {@code false} otherwise.
+ */
+bool loadImage(const string& filename, QuadImage& image) {
+    ifstream fin(filename, ios::binary);
+
+    if (!fin.is_open()) {
+        fprintf(stderr, "error: could not open the input file '%s'!\n", filename.c_str());
+        return false;
+    }
+
+    char magic[4];
+    fin.read(magic, sizeof(magic));
+
+    // Binary image
+    if (QuadImage::isImage(magic, fin.gcount())) {
+        fin.close();
+
+        if (!image.open(filename)) {
+            fprintf(stderr, "error: invalid or incompatible binary image '%s'!\n", filename.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    // Quadruples text
+    fin.clear();
+    fin.seekg(0);
+
+    vector<QuadProc> procs;
+    QuadTextReader reader;
+
+    if (!reader.read(fin, procs)) {
+        fprintf(stderr, "error: %s: %s!\n", filename.c_str(), reader.getError().c_str());
+        return false;
+    }
+
+    ostringstream out;
+    QuadBinaryWriter writer(out);
+
+    for (int i = 0; i < procs.size(); ++i) {
+        writer.write(procs[i]);
+    }
+
+    writer.finish();
+
+    string str = out.str();
+    vector<char> bytes(str.begin(), str.end());
+
+    if (writer.hasFailed()) {
+        fprintf(stderr, "error: could not translate the quadruples of '%s'!\n", filename.c_str());
+        return false;
+    }
+
+    if (!image.load(bytes)) {
+        fprintf(stderr, "error: invalid quadruples '%s'!\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Prints the help menu of the virtual machine into the
+ * standard output stream, then terminates the program.
+ */
+void printHelp() {
+    printf("%s version %s\n\n", VM_NAME, VERSION);
+    printf("Usage: %s [switches] <input_file>\n", VM_NAME);
+    printf("    -h, --help                   Print the help menu and exit.\n");
+    printf("    --stats                      Print the execution statistics.\n");
+    exit(0);
+}
+
+/**
+ * Parses the passed arguments to the agent, and updates global variables in correspondence.
+ *
+ * @param argc the number of arguments sent to the program.
+ * @param argv the arguments them self as sent to the program.
+ */
+void parseArguments(int argc, char* argv[]) {
+    // Iterate over all sent arguments
+    while (++argv, --argc) {
+        // Commands begin with dash "-"
+        if (**argv == '-') {
+            // Print help menu
+            if (strcmp(*argv, "-h") == 0 || strcmp(*argv, "--help") == 0) {
+                printHelp();
+            }
+            // Show execution statistics
+            else if (strcmp(*argv, "--stats") == 0) {
+                showStats = true;
+            }
+            // Invalid command
+            else {
+                fprintf(stderr, "unknown argument '%s'\n", *argv);
+            }
+        }
+        // Set input filename
+        else if (inputFilename.empty()) {
+            inputFilename = string(*argv);
+        }
+        // Other arguments
+        else {
+            fprintf(stderr, "warning: too many arguments, '%s' ignored\n", *argv);
+        }
+    }
+
+    // Check if input filename is specified
+    if (inputFilename.empty()) {
+        fprintf(stderr, "error: missing input filename argument!\n\n");
+        printHelp();
+    }
+}
\ No newline at end of file
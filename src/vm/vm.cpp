@@ -0,0 +1,466 @@
+#include <cstring>
+#include <limits>
+
+#include "vm.h"
+
+
+//
+// Dispatch definitions
+//
+// The instructions are dispatched using computed gotos (a.k.a. threaded code) when
+// supported by the compiler, so that each handler jumps directly into the next one
+// without going back to a central switch. Otherwise, a plain switch loop is used.
+//
+#if defined(__GNUC__) && !defined(VM_NO_THREADING)
+#define VM_THREADED
+#endif
+
+//
+// List of the instruction handlers and their opcodes
+//
+#define TYPED(X, NAME, BASE) \
+    X(NAME##_BOOL, BASE) X(NAME##_CHR, BASE + 1) X(NAME##_INT, BASE + 2) X(NAME##_FLOAT, BASE + 3)
+
+#define CONV_FROM(X, FROM, IDX) \
+    X(FROM##_TO_BOOL, IMG_CONV + IDX * 4) X(FROM##_TO_CHR, IMG_CONV + IDX * 4 + 1) \
+    X(FROM##_TO_INT, IMG_CONV + IDX * 4 + 2) X(FROM##_TO_FLOAT, IMG_CONV + IDX * 4 + 3)
+
+#define VM_INSTRUCTIONS(X) \
+    X(PUSH_IMM, IMG_PUSH_IMM) \
+    X(PUSH_LOCAL, IMG_PUSH_LOCAL) \
+    X(PUSH_GLOBAL, IMG_PUSH_GLOBAL) \
+    X(POP_LOCAL, IMG_POP_LOCAL) \
+    X(POP_GLOBAL, IMG_POP_GLOBAL) \
+    X(POP, IMG_POP) \
+    X(DUP, IMG_DUP) \
+    X(JMP, IMG_JMP) \
+    X(JTAB, IMG_JTAB) \
+    X(CALL, IMG_CALL) \
+    X(RET, IMG_RET) \
+    X(HALT, IMG_OPCODE_COUNT) \
+    TYPED(X, JZ, IMG_JZ) \
+    TYPED(X, JNZ, IMG_JNZ) \
+    TYPED(X, JGT, IMG_JGT) \
+    TYPED(X, JGE, IMG_JGE) \
+    TYPED(X, JLT, IMG_JLT) \
+    TYPED(X, JLE, IMG_JLE) \
+    TYPED(X, JEQ, IMG_JEQ) \
+    TYPED(X, JNE, IMG_JNE) \
+    TYPED(X, ADD, IMG_ADD) \
+    TYPED(X, SUB, IMG_SUB) \
+    TYPED(X, MUL, IMG_MUL) \
+    TYPED(X, DIV, IMG_DIV) \
+    TYPED(X, GT, IMG_GT) \
+    TYPED(X, GTE, IMG_GTE) \
+    TYPED(X, LT, IMG_LT) \
+    TYPED(X, LTE, IMG_LTE) \
+    TYPED(X, EQU, IMG_EQU) \
+    TYPED(X, NEQ, IMG_NEQ) \
+    TYPED(X, AND, IMG_AND) \
+    TYPED(X, OR, IMG_OR) \
+    TYPED(X, NOT, IMG_NOT) \
+    TYPED(X, NEG, IMG_NEG) \
+    TYPED(X, INC, IMG_INC) \
+    TYPED(X, DEC, IMG_DEC) \
+    X(MOD_BOOL, IMG_MOD) X(MOD_CHR, IMG_MOD + 1) X(MOD_INT, IMG_MOD + 2) \
+    X(XOR_BOOL, IMG_XOR) X(XOR_CHR, IMG_XOR + 1) X(XOR_INT, IMG_XOR + 2) \
+    X(SHL_BOOL, IMG_SHL) X(SHL_CHR, IMG_SHL + 1) X(SHL_INT, IMG_SHL + 2) \
+    X(SHR_BOOL, IMG_SHR) X(SHR_CHR, IMG_SHR + 1) X(SHR_INT, IMG_SHR + 2) \
+    CONV_FROM(X, BOOL, 0) \
+    CONV_FROM(X, CHR, 1) \
+    CONV_FROM(X, INT, 2) \
+    CONV_FROM(X, FLOAT, 3)
+
+#define VM_OPCODE(NAME, OP) VM_##NAME = (OP),
+enum VMOpcode { VM_INSTRUCTIONS(VM_OPCODE) };
+#undef VM_OPCODE
+
+#ifdef VM_THREADED
+#define TARGET(NAME)    L_##NAME:
+#define DISPATCH()      { ip = pc++; ++count; goto *targets[ip->opcode]; }
+#else
+#define TARGET(NAME)    case VM_##NAME:
+#define DISPATCH()      continue
+#endif
+
+//
+// Typed instruction handlers
+//
+#define HANDLE_TYPED(MACRO, NAME, OP) \
+    MACRO(NAME##_BOOL, boolVal, bool, OP) \
+    MACRO(NAME##_CHR, charVal, char, OP) \
+    MACRO(NAME##_INT, intVal, int, OP) \
+    MACRO(NAME##_FLOAT, floatVal, float, OP)
+
+#define HANDLE_INTEGER(MACRO, NAME, OP) \
+    MACRO(NAME##_BOOL, boolVal, bool, OP) \
+    MACRO(NAME##_CHR, charVal, char, OP) \
+    MACRO(NAME##_INT, intVal, int, OP)
+
+#define HANDLE_WRAPPING(NAME, OP) \
+    BINARY(NAME##_BOOL, boolVal, bool, OP) \
+    BINARY(NAME##_CHR, charVal, char, OP) \
+    WRAPPING(NAME##_INT, intVal, int, OP) \
+    BINARY(NAME##_FLOAT, floatVal, float, OP)
+
+#define BINARY(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].F = (T) (sp[-2].F OP sp[-1].F); \
+        --sp; \
+        DISPATCH();
+
+// Integer arithmetic wraps around on overflow like the constant folder, through unsigned arithmetic
+#define WRAPPING(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].F = (T) ((unsigned) sp[-2].F OP (unsigned) sp[-1].F); \
+        --sp; \
+        DISPATCH();
+
+// The shift count is masked to the width of an integer like the target machine,
+// and the left shift is unsigned so the shifted out bits are dropped
+#define SHIFT_LEFT(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].F = (T) ((unsigned) sp[-2].F OP (sp[-1].F & 31)); \
+        --sp; \
+        DISPATCH();
+
+#define SHIFT_RIGHT(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].F = (T) ((int) sp[-2].F OP (sp[-1].F & 31)); \
+        --sp; \
+        DISPATCH();
+
+// Dividing the minimum value by -1 overflows, so its quotient wraps around to the minimum value
+// and its remainder is 0, instead of trapping like the host machine
+#define DIVISION(NAME, F, T, OP) \
+    TARGET(NAME) \
+        if (sp[-1].F == 0) goto divByZero; \
+        if (numeric_limits<T>::is_signed && sp[-1].F == (T) -1) { \
+            sp[-2].F = (T) (0u - (unsigned) sp[-2].F); \
+        } else { \
+            sp[-2].F = (T) (sp[-2].F OP sp[-1].F); \
+        } \
+        --sp; \
+        DISPATCH();
+
+#define MODULO(NAME, F, T, OP) \
+    TARGET(NAME) \
+        if (sp[-1].F == 0) goto divByZero; \
+        if (numeric_limits<T>::is_signed && sp[-1].F == (T) -1) { \
+            sp[-2].F = 0; \
+        } else { \
+            sp[-2].F = (T) (sp[-2].F OP sp[-1].F); \
+        } \
+        --sp; \
+        DISPATCH();
+
+#define COMPARE(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].boolVal = (sp[-2].F OP sp[-1].F); \
+        --sp; \
+        DISPATCH();
+
+#define LOGICAL(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-2].boolVal = ((sp[-2].F != 0) OP (sp[-1].F != 0)); \
+        --sp; \
+        DISPATCH();
+
+#define UNARY(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp[-1].F = (T) (OP); \
+        DISPATCH();
+
+#define BRANCH(NAME, F, T, OP) \
+    TARGET(NAME) \
+        --sp; \
+        if ((sp->F != 0) OP) pc = base + ip->arg; \
+        DISPATCH();
+
+#define COMPARE_BRANCH(NAME, F, T, OP) \
+    TARGET(NAME) \
+        sp -= 2; \
+        if (sp[0].F OP sp[1].F) pc = base + ip->arg; \
+        DISPATCH();
+
+#define CONV(NAME, F, T, FROM) \
+    TARGET(FROM##_TO_##NAME) \
+        sp[-1].F = (T) sp[-1].FROM##_FIELD; \
+        DISPATCH();
+
+#define BOOL_FIELD  boolVal
+#define CHR_FIELD   charVal
+#define INT_FIELD   intVal
+#define FLOAT_FIELD floatVal
+
+
+QuadVM::QuadVM(const QuadImage& image) : image(image) {
+    stack.resize(VM_STACK_SIZE);
+    locals.resize(VM_LOCALS_SIZE);
+    globals.assign(image.header->globalCount, Value());
+    frames.reserve(VM_MAX_CALL_DEPTH);
+
+    sp = stack.data();
+    localsTop = locals.data();
+}
+
+bool QuadVM::run() {
+    // Run the global initialization code
+    if (!execute(0)) {
+        return false;
+    }
+
+    if (image.header->mainProc < 0) {
+        return true;
+    }
+
+    Value* spBase = sp;
+
+    if (!execute(image.header->mainProc)) {
+        return false;
+    }
+
+    // Take the returned value of the main procedure, if any, as the exit code
+    if (sp > spBase) {
+        exitCode = (--sp)->intVal;
+    }
+
+    return true;
+}
+
+bool QuadVM::execute(uint32_t procIdx) {
+    static const ImageInstr halt = {VM_HALT, 0, {0}};
+
+#ifdef VM_THREADED
+    static void* targets[IMG_OPCODE_COUNT + 1];
+    static bool targetsReady = false;
+
+    if (!targetsReady) {
+        for (int i = 0; i <= IMG_OPCODE_COUNT; ++i) {
+            targets[i] = &&L_INVALID;
+        }
+
+#define VM_TARGET(NAME, OP) targets[OP] = &&L_##NAME;
+        VM_INSTRUCTIONS(VM_TARGET)
+#undef VM_TARGET
+
+        targetsReady = true;
+    }
+#endif
+
+    const ImageProc* procs = image.procs;
+    const ImageInstr* code = image.code;
+
+    // Keep the machine registers in local variables during the execution
+    Value* sp = this->sp;
+    Value* fp = localsTop;
+    Value* gp = globals.data();
+    Value* spEnd = stack.data() + stack.size();
+    Value* localsEnd = locals.data() + locals.size();
+
+    const ImageInstr* base = code + procs[procIdx].codeStart;
+    const ImageInstr* pc = base;
+    const ImageInstr* ip = pc;
+    uint64_t count = 0;
+
+    // Enter the procedure, returning into the halt instruction
+    if (fp + procs[procIdx].frameSize > localsEnd || frames.size() >= VM_MAX_CALL_DEPTH) {
+        goto stackOverflow;
+    }
+
+    frames.push_back({&halt, &halt, fp});
+    localsTop = fp + procs[procIdx].frameSize;
+    memset(fp, 0, procs[procIdx].frameSize * sizeof(Value));
+
+#ifdef VM_THREADED
+    DISPATCH();
+#else
+    for (;;) {
+        ip = pc++;
+        ++count;
+
+        switch (ip->opcode) {
+#endif
+
+    TARGET(PUSH_IMM)
+        if (sp == spEnd) goto stackOverflow;
+        *sp++ = ip->value;
+        DISPATCH();
+
+    TARGET(PUSH_LOCAL)
+        if (sp == spEnd) goto stackOverflow;
+        *sp++ = fp[ip->arg];
+        DISPATCH();
+
+    TARGET(PUSH_GLOBAL)
+        if (sp == spEnd) goto stackOverflow;
+        *sp++ = gp[ip->arg];
+        DISPATCH();
+
+    TARGET(POP_LOCAL)
+        fp[ip->arg] = *--sp;
+        DISPATCH();
+
+    TARGET(POP_GLOBAL)
+        gp[ip->arg] = *--sp;
+        DISPATCH();
+
+    TARGET(POP)
+        --sp;
+        DISPATCH();
+
+    TARGET(DUP)
+        if (sp == spEnd) goto stackOverflow;
+        *sp = sp[-1];
+        ++sp;
+        DISPATCH();
+
+    TARGET(JMP)
+        pc = base + ip->arg;
+        DISPATCH();
+
+    TARGET(JTAB)
+        --sp;
+        pc = base + pc[(uint32_t) sp->intVal < (uint32_t) ip->arg ? 1 + sp->intVal : 0].arg;
+        DISPATCH();
+
+    TARGET(CALL)
+        {
+            const ImageProc& p = procs[ip->arg];
+
+            if (localsTop + p.frameSize > localsEnd || frames.size() >= VM_MAX_CALL_DEPTH) {
+                goto stackOverflow;
+            }
+
+            frames.push_back({pc, base, fp});
+            fp = localsTop;
+            localsTop += p.frameSize;
+            memset(fp, 0, p.frameSize * sizeof(Value));
+
+            base = pc = code + p.codeStart;
+        }
+        DISPATCH();
+
+    TARGET(RET)
+        {
+            const VMFrame& f = frames.back();
+            localsTop = fp;
+            fp = f.retLocals;
+            pc = f.retPc;
+            base = f.retBase;
+            frames.pop_back();
+        }
+        DISPATCH();
+
+    TARGET(HALT)
+        this->sp = sp;
+        retired += count - 1;
+        return true;
+
+    HANDLE_TYPED(BRANCH, JZ, == false)
+    HANDLE_TYPED(BRANCH, JNZ, == true)
+    HANDLE_TYPED(COMPARE_BRANCH, JGT, >)
+    HANDLE_TYPED(COMPARE_BRANCH, JGE, >=)
+    HANDLE_TYPED(COMPARE_BRANCH, JLT, <)
+    HANDLE_TYPED(COMPARE_BRANCH, JLE, <=)
+    HANDLE_TYPED(COMPARE_BRANCH, JEQ, ==)
+    HANDLE_TYPED(COMPARE_BRANCH, JNE, !=)
+
+    HANDLE_WRAPPING(ADD, +)
+    HANDLE_WRAPPING(SUB, -)
+    HANDLE_WRAPPING(MUL, *)
+    HANDLE_INTEGER(DIVISION, DIV, /)
+    HANDLE_INTEGER(MODULO, MOD, %)
+    HANDLE_INTEGER(BINARY, XOR, ^)
+    HANDLE_INTEGER(SHIFT_LEFT, SHL, <<)
+    HANDLE_INTEGER(SHIFT_RIGHT, SHR, >>)
+
+    // Float division follows IEEE semantics, float logical operators operate on the truth values
+    BINARY(DIV_FLOAT, floatVal, float, /)
+    HANDLE_INTEGER(BINARY, AND, &)
+    HANDLE_INTEGER(BINARY, OR, |)
+    LOGICAL(AND_FLOAT, floatVal, float, &&)
+    LOGICAL(OR_FLOAT, floatVal, float, ||)
+
+    HANDLE_TYPED(COMPARE, GT, >)
+    HANDLE_TYPED(COMPARE, GTE, >=)
+    HANDLE_TYPED(COMPARE, LT, <)
+    HANDLE_TYPED(COMPARE, LTE, <=)
+    HANDLE_TYPED(COMPARE, EQU, ==)
+    HANDLE_TYPED(COMPARE, NEQ, !=)
+
+    UNARY(NOT_BOOL, boolVal, bool, !sp[-1].boolVal)
+    UNARY(NOT_CHR, charVal, char, ~sp[-1].charVal)
+    UNARY(NOT_INT, intVal, int, ~sp[-1].intVal)
+    TARGET(NOT_FLOAT)
+        sp[-1].boolVal = (sp[-1].floatVal == 0);
+        DISPATCH();
+
+    UNARY(NEG_BOOL, boolVal, bool, sp[-1].boolVal)
+    UNARY(NEG_CHR, charVal, char, -sp[-1].charVal)
+    UNARY(NEG_INT, intVal, int, 0u - (unsigned) sp[-1].intVal)
+    UNARY(NEG_FLOAT, floatVal, float, -sp[-1].floatVal)
+
+    UNARY(INC_BOOL, boolVal, bool, true)
+    UNARY(INC_CHR, charVal, char, sp[-1].charVal + 1)
+    UNARY(INC_INT, intVal, int, (unsigned) sp[-1].intVal + 1u)
+    UNARY(INC_FLOAT, floatVal, float, sp[-1].floatVal + 1)
+
+    UNARY(DEC_BOOL, boolVal, bool, !sp[-1].boolVal)
+    UNARY(DEC_CHR, charVal, char, sp[-1].charVal - 1)
+    UNARY(DEC_INT, intVal, int, (unsigned) sp[-1].intVal - 1u)
+    UNARY(DEC_FLOAT, floatVal, float, sp[-1].floatVal - 1)
+
+    CONV(BOOL, boolVal, bool, BOOL)
+    CONV(CHR, charVal, char, BOOL)
+    CONV(INT, intVal, int, BOOL)
+    CONV(FLOAT, floatVal, float, BOOL)
+    CONV(BOOL, boolVal, bool, CHR)
+    CONV(CHR, charVal, char, CHR)
+    CONV(INT, intVal, int, CHR)
+    CONV(FLOAT, floatVal, float, CHR)
+    CONV(BOOL, boolVal, bool, INT)
+    CONV(CHR, charVal, char, INT)
+    CONV(INT, intVal, int, INT)
+    CONV(FLOAT, floatVal, float, INT)
+    CONV(BOOL, boolVal, bool, FLOAT)
+    CONV(CHR, charVal, char, FLOAT)
+    CONV(INT, intVal, int, FLOAT)
+    CONV(FLOAT, floatVal, float, FLOAT)
+
+#ifdef VM_THREADED
+    L_INVALID:
+#else
+            default:
+                break;
+        }
+#endif
+
+    error = "invalid instruction " + to_string(ip->opcode);
+    goto fail;
+
+#ifndef VM_THREADED
+    }
+#endif
+
+divByZero:
+    error = "integer division by zero";
+    goto fail;
+
+stackOverflow:
+    error = "stack overflow";
+    goto fail;
+
+fail:
+    // Locate the failing instruction
+    for (uint32_t i = 0; i < image.header->procCount; ++i) {
+        if (code + procs[i].codeStart == base) {
+            error += " in procedure '" + string(image.getString(procs[i].name)) + "'";
+            error += " at instruction " + to_string(ip - base);
+            break;
+        }
+    }
+
+    retired += count;
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef __VM_H_
+#define __VM_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "../quadruples/quad_image.h"
+
+using namespace std;
+
+
+//
+// Virtual machine definitions
+//
+#define VM_STACK_SIZE       (1 << 16)
+#define VM_LOCALS_SIZE      (1 << 20)
+#define VM_MAX_CALL_DEPTH   (1 << 16)
+
+/**
+ * Struct holding the state of a procedure call.
+ */
+struct VMFrame {
+    const ImageInstr* retPc;        // The instruction to return to
+    const ImageInstr* retBase;      // The first instruction of the procedure to return to
+    Value* retLocals;               // The local variables of the procedure to return to
+};
+
+/**
+ * Quadruples virtual machine.
+ *
+ * Executes a loaded binary quadruples image directly, using a typed operand stack of values.
+ * All symbols are already resolved into frame or global slots by the image,
+ * and the image loader rejects any stack underflow, so the instructions are dispatched without any lookups or operand checks.
+ */
+class QuadVM {
+private:
+    const QuadImage& image;
+
+    vector<Value> stack;
+    vector<Value> locals;
+    vector<Value> globals;
+    vector<VMFrame> frames;
+
+    Value* sp;                      // The top of the operand stack (the next free entry)
+    Value* localsTop;               // The end of the local variables of the current frame
+
+    uint64_t retired = 0;
+    int exitCode = 0;
+    string error;
+
+public:
+
+    /**
+     * Constructs a new virtual machine for the given image.
+     *
+     * @param image the validated image to execute.
+     */
+    QuadVM(const QuadImage& image);
+
+    /**
+     * Runs the global initialization code of the image, then its main procedure, if any.
+     *
+     * @return {@code true} if the program terminated normally; {@code false} on runtime errors.
+     */
+    bool run();
+
+    /**
+     * Returns the value returned by the main procedure, or 0 if it does not return a value.
+     *
+     * @return the exit code of the program.
+     */
+    int getExitCode() {
+        return exitCode;
+    }
+
+    /**
+     * Returns the number of instructions executed so far.
+     *
+     * @return the number of retired instructions.
+     */
+    uint64_t getRetiredCount() {
+        return retired;
+    }
+
+    /**
+     * Returns the message of the runtime error that terminated the program.
+     *
+     * @return the error message.
+     */
+    string getError() {
+        return error;
+    }
+
+private:
+
+    bool execute(uint32_t procIdx);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#
+# Compiles a test program into text and binary quadruples, at each optimization level,
+# then runs each output on the virtual machine and checks its exit code.
+#
+# The expected exit code is given by the first line of the program, as "// expect: <code>".
+#
+# Usage: cmake -DCOMPILER=<mpp> -DVM=<mpp-run> -DPROGRAM=<file.mpp> -DWORK_DIR=<dir> -P run_program.cmake
+#
+
+file(STRINGS ${PROGRAM} header LIMIT_COUNT 1)
+
+if (NOT header MATCHES "^// expect: ([0-9]+)")
+    message(FATAL_ERROR "${PROGRAM}: missing the expected exit code")
+endif ()
+
+set(expected ${CMAKE_MATCH_1})
+get_filename_component(name ${PROGRAM} NAME_WE)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+foreach (level 0 1)
+    foreach (format text binary)
+        set(output ${WORK_DIR}/${name}-O${level}.${format})
+
+        execute_process(
+                COMMAND ${COMPILER} -O${level} --emit=${format} ${PROGRAM} -o ${output}
+                RESULT_VARIABLE status
+                ERROR_VARIABLE errors
+        )
+
+        if (NOT status EQUAL 0 OR NOT errors STREQUAL "")
+            message(FATAL_ERROR "${PROGRAM}: compilation failed at -O${level} --emit=${format}\n${errors}")
+        endif ()
+
+        execute_process(COMMAND ${VM} ${output} RESULT_VARIABLE status)
+
+        if (NOT status EQUAL expected)
+            message(FATAL_ERROR "${PROGRAM}: exited with ${status} instead of ${expected} at -O${level} --emit=${format}")
+        endif ()
+    endforeach ()
+endforeach ()